@@ -0,0 +1,264 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include "engine/Hash.h"
+
+AssetLoader::AssetLoader(const AssetBundle* bundle, const ImageCache* imageCache, std::function<std::string(const std::string&)> loosePath, unsigned threadCount)
+    : bundle(bundle), imageCache(imageCache), loosePath(std::move(loosePath)) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&AssetLoader::work, this);
+    }
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int AssetLoader::loadImage(const std::string& name, const std::string& description) {
+    return enqueue(Kind::Image, name, description);
+}
+
+int AssetLoader::loadImage(const std::string& name, const std::string& description, sf::Vector2u targetSize) {
+    return enqueue(Kind::Image, name, description, targetSize);
+}
+
+int AssetLoader::loadSound(const std::string& name, const std::string& description) {
+    return enqueue(Kind::Sound, name, description);
+}
+
+int AssetLoader::loadFont(const std::string& name, const std::string& description) {
+    return enqueue(Kind::Font, name, description);
+}
+
+int AssetLoader::enqueue(Kind kind, const std::string& name, const std::string& description, sf::Vector2u targetSize) {
+    int id = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // Asking for the same asset again shares the first request's decode
+        for (size_t i = 0; i < assets.size(); ++i) {
+            const Asset& queued = *assets[i];
+            if (queued.kind != kind || queued.name != name || queued.targetSize != targetSize) {
+                continue;
+            }
+            id = static_cast<int>(i);
+            if (queued.state.load(std::memory_order_acquire) != Released) {
+                return id;
+            }
+            assets[i]->state.store(Pending, std::memory_order_release);
+            releasedCount--;
+            queue.push_back(id);
+            break;
+        }
+
+        if (id < 0) {
+            id = static_cast<int>(assets.size());
+            assets.emplace_back(new Asset());
+            assets.back()->kind = kind;
+            assets.back()->name = name;
+            assets.back()->description = description;
+            assets.back()->targetSize = targetSize;
+            queue.push_back(id);
+        }
+    }
+    wake.notify_one();
+    return id;
+}
+
+void AssetLoader::work() {
+    for (;;) {
+        Asset* asset;
+        int id;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping) {
+                return;
+            }
+            id = queue.front();
+            queue.pop_front();
+            asset = assets[id].get();
+        }
+
+        bool loaded = decode(*asset);
+        asset->state.store(loaded ? Ready : Failed, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        finished.push_back(id);
+        finishedCount++;
+        if (loaded) {
+            readyCount++;
+        }
+        else if (firstError.empty()) {
+            firstError = asset->description;
+        }
+    }
+}
+
+bool AssetLoader::readSource(const Asset& asset, std::vector<char>& looseBytes, const void*& data, size_t& size) const {
+    // Use the mapped bundle entry in place when there is one
+    size = 0;
+    data = bundle != nullptr && bundle->isOpen() ? bundle->find(asset.name, size) : nullptr;
+    if (data != nullptr) {
+        return true;
+    }
+
+    std::ifstream in(loosePath(asset.name), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    looseBytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    data = looseBytes.data();
+    size = looseBytes.size();
+    return true;
+}
+
+bool AssetLoader::decode(Asset& asset) const {
+    if (asset.kind == Kind::Image) {
+        return decodeImage(asset);
+    }
+
+    // Decode in place from the mapped bundle when it has the entry
+    size_t size = 0;
+    const void* data = bundle != nullptr && bundle->isOpen() ? bundle->find(asset.name, size) : nullptr;
+    if (data != nullptr) {
+        return asset.kind == Kind::Sound ? asset.sound.loadFromMemory(data, size) : asset.font.loadFromMemory(data, size);
+    }
+
+    std::string path = loosePath(asset.name);
+    return asset.kind == Kind::Sound ? asset.sound.loadFromFile(path) : asset.font.loadFromFile(path);
+}
+
+bool AssetLoader::decodeImage(Asset& asset) const {
+    // Images are identified by their source bytes, so those are needed either way
+    std::vector<char> looseBytes;
+    const void* data;
+    size_t size;
+    if (!readSource(asset, looseBytes, data, size)) {
+        return false;
+    }
+    uint64_t sourceHash = hashBytes(data, size);
+
+    unsigned width = asset.targetSize.x;
+    unsigned height = asset.targetSize.y;
+    if (width == 0 || height == 0) {
+        asset.contentHash = sourceHash;
+        return asset.image.loadFromMemory(data, size);
+    }
+
+    // The same source resized to another size is different content
+    asset.contentHash = hashBytes(&width, sizeof(width), hashBytes(&height, sizeof(height), sourceHash));
+    if (imageCache != nullptr) {
+        MappedFile cached;
+        if (const uint8_t* pixels = imageCache->map(asset.name, sourceHash, width, height, cached)) {
+            asset.image.create(width, height, pixels);
+            return true;
+        }
+    }
+
+    // Missing or stale entry: decode, resize and write a fresh entry for the next run
+    sf::Image decoded;
+    if (!decoded.loadFromMemory(data, size)) {
+        return false;
+    }
+    if (decoded.getSize() == asset.targetSize) {
+        asset.image = decoded;
+    }
+    else {
+        std::vector<uint8_t> resized(static_cast<size_t>(width) * height * 4);
+        resizeImage(decoded.getPixelsPtr(), decoded.getSize().x, decoded.getSize().y, resized.data(), width, height);
+        asset.image.create(width, height, resized.data());
+    }
+    if (imageCache != nullptr) {
+        imageCache->store(asset.name, sourceHash, width, height, asset.image.getPixelsPtr());
+    }
+    return true;
+}
+
+bool AssetLoader::isReady(int asset) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return assets[asset]->state.load(std::memory_order_acquire) == Ready;
+}
+
+bool AssetLoader::allReady() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return readyCount == static_cast<int>(assets.size()) - releasedCount;
+}
+
+void AssetLoader::release(int asset) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Only finished images: a pending asset may be in a worker's hands
+    Asset& released = *assets[asset];
+    if (released.kind != Kind::Image || released.state.load(std::memory_order_acquire) != Ready) {
+        return;
+    }
+    released.image = sf::Image();
+    released.state.store(Released, std::memory_order_release);
+    readyCount--;
+    finishedCount--;
+    releasedCount++;
+}
+
+size_t AssetLoader::decodedBytes() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t total = 0;
+    for (const auto& asset : assets) {
+        if (asset->kind == Kind::Image && asset->state.load(std::memory_order_acquire) == Ready) {
+            total += static_cast<size_t>(asset->image.getSize().x) * asset->image.getSize().y * 4;
+        }
+    }
+    return total;
+}
+
+std::vector<int> AssetLoader::takeFinished() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<int> taken;
+    taken.swap(finished);
+    return taken;
+}
+
+std::string AssetLoader::error() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return firstError;
+}
+
+float AssetLoader::progress() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    int queued = static_cast<int>(assets.size()) - releasedCount;
+    return queued == 0 ? 1.f : static_cast<float>(finishedCount) / queued;
+}
+
+uint64_t AssetLoader::contentHash(int asset) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    // A worker may still be writing it; the state's release store publishes it
+    const Asset& found = *assets[asset];
+    int state = found.state.load(std::memory_order_acquire);
+    return state == Ready || state == Released ? found.contentHash : 0;
+}
+
+const sf::Image& AssetLoader::image(int asset) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return assets[asset]->image;
+}
+
+const sf::SoundBuffer& AssetLoader::sound(int asset) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return assets[asset]->sound;
+}
+
+sf::Font& AssetLoader::font(int asset) {
+    std::lock_guard<std::mutex> lock(mutex);
+    return assets[asset]->font;
+}
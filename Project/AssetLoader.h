@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <SFML/Audio.hpp>
+#include <SFML/Graphics.hpp>
+#include "engine/AssetBundle.h"
+#include "engine/ImageCache.h"
+
+// Decodes images, sounds and fonts on a pool of worker threads. Assets are
+// decoded in the order they are queued, so whatever the first screen needs
+// should be queued first. Nothing here touches OpenGL: the caller uploads
+// textures on the window's thread as takeFinished() reports them.
+//
+// Assets are named by their entry in the asset bundle and decoded straight
+// from the mapped bundle; entries missing from the bundle are read from the
+// loose file that loosePath gives for the name.
+//
+// Images queued with a target size are resized to it once and kept in the
+// image cache, so later runs copy the pixels instead of decoding the file.
+class AssetLoader {
+public:
+    // Start the worker threads; 0 uses one per hardware thread. The bundle may be
+    // null or unopened, and must outlive every asset decoded from it. The image
+    // cache may be null to always decode.
+    AssetLoader(const AssetBundle* bundle, const ImageCache* imageCache, std::function<std::string(const std::string&)> loosePath, unsigned threadCount = 0);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Queue a decode and return the asset's id; description is used in error messages.
+    // Queuing an asset that is already queued returns the existing id, and
+    // queues the decode again if the asset was released.
+    int loadImage(const std::string& name, const std::string& description);
+    int loadSound(const std::string& name, const std::string& description);
+    int loadFont(const std::string& name, const std::string& description);
+
+    // Queue an image that is only ever drawn at the given size, such as a
+    // full-screen background; it is decoded at that size through the image cache
+    int loadImage(const std::string& name, const std::string& description, sf::Vector2u targetSize);
+
+    // Whether the asset finished decoding successfully
+    bool isReady(int asset) const;
+
+    // Free a decoded image that is no longer needed, such as one already
+    // uploaded to a texture; loading it again decodes it again
+    void release(int asset);
+
+    // CPU memory held by decoded images
+    size_t decodedBytes() const;
+
+    // Whether every queued asset that was not released finished decoding successfully
+    bool allReady() const;
+
+    // Assets that finished decoding since the last call, in completion order
+    std::vector<int> takeFinished();
+
+    // Description of the first asset that failed to load, or an empty string
+    std::string error() const;
+
+    // Fraction of queued assets that finished, for a progress bar
+    float progress() const;
+
+    // Hash identifying a decoded image's pixels: its source bytes and target size.
+    // 0 until the image has decoded.
+    uint64_t contentHash(int asset) const;
+
+    // Decoded data; only valid once isReady(asset) is true
+    const sf::Image& image(int asset) const;
+    const sf::SoundBuffer& sound(int asset) const;
+    sf::Font& font(int asset);
+
+private:
+    enum class Kind { Image, Sound, Font };
+    enum State { Pending, Ready, Failed, Released };
+
+    struct Asset {
+        Kind kind;
+        std::string name;
+        std::string description;
+        sf::Vector2u targetSize;              // Size to decode an image at; zero keeps its own size
+        uint64_t contentHash = 0;             // See AssetLoader::contentHash
+        sf::Image image;
+        sf::SoundBuffer sound;
+        sf::Font font;
+        std::atomic<int> state{ Pending };
+    };
+
+    // Add an asset to the queue and wake a worker
+    int enqueue(Kind kind, const std::string& name, const std::string& description, sf::Vector2u targetSize = sf::Vector2u());
+
+    // Worker thread body: decode queued assets until stopped
+    void work();
+
+    // Decode one asset from the bundle or its loose file; returns false on failure
+    bool decode(Asset& asset) const;
+
+    // Decode an image, at its target size through the image cache when it has one
+    bool decodeImage(Asset& asset) const;
+
+    // Find an asset's encoded bytes: its bundle entry in place, or its loose file read into looseBytes
+    bool readSource(const Asset& asset, std::vector<char>& looseBytes, const void*& data, size_t& size) const;
+
+    const AssetBundle* bundle;
+    const ImageCache* imageCache;
+    std::function<std::string(const std::string&)> loosePath;
+
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<std::unique_ptr<Asset>> assets;  // Stable addresses while the deque grows
+    std::deque<int> queue;                      // Assets waiting for a worker
+    std::vector<int> finished;                  // Assets decoded since the last takeFinished
+    int finishedCount = 0;
+    int readyCount = 0;
+    int releasedCount = 0;
+    std::string firstError;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
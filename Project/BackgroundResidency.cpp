@@ -0,0 +1,161 @@
+#include "BackgroundResidency.h"
+
+BackgroundResidency::BackgroundResidency(AssetLoader& assets, TextureManager& textures, size_t gpuBudget, size_t cpuBudget)
+    : assets(assets), textures(textures), gpuBudget(gpuBudget), cpuBudget(cpuBudget) {
+}
+
+void BackgroundResidency::addScreen(const std::string& name, const std::string& description, sf::Vector2u size) {
+    screens.emplace_back();
+    screens.back().name = name;
+    screens.back().description = description;
+    screens.back().size = size;
+}
+
+bool BackgroundResidency::isWanted(int screen) const {
+    return current >= 0 && (screen == current || screen == current + 1);
+}
+
+size_t BackgroundResidency::imageBytes(int screen) const {
+    return static_cast<size_t>(screens[screen].size.x) * screens[screen].size.y * 4;
+}
+
+void BackgroundResidency::enterScreen(int screen) {
+    current = screen;
+    for (int i = 0; i < static_cast<int>(screens.size()); ++i) {
+        if (!isWanted(i)) {
+            evict(i);
+        }
+    }
+    request(current);
+    // The prefetch starts on the next update, behind anything queued meanwhile
+    prefetchDeferred = current + 1 < static_cast<int>(screens.size());
+}
+
+void BackgroundResidency::update() {
+    if (!prefetchDeferred) {
+        return;
+    }
+
+    // Prefetch only what fits next to everything already held
+    int next = current + 1;
+    if (!residentTexture(next) && (gpuBytes() + imageBytes(next) > gpuBudget || assets.decodedBytes() + imageBytes(next) > cpuBudget)) {
+        return;
+    }
+    prefetchDeferred = false;
+    request(next);
+}
+
+std::shared_ptr<const sf::Texture> BackgroundResidency::residentTexture(int screen) const {
+    const Screen& wanted = screens[screen];
+    for (const Screen& other : screens) {
+        if (other.texture && other.name == wanted.name && other.size == wanted.size) {
+            return other.texture;
+        }
+    }
+    // The hash stays 0 until the image has decoded, and is kept once the
+    // decoded pixels are released after upload
+    uint64_t hash = wanted.asset >= 0 ? assets.contentHash(wanted.asset) : 0;
+    return hash != 0 ? textures.find(hash) : nullptr;
+}
+
+void BackgroundResidency::request(int screen) {
+    Screen& wanted = screens[screen];
+    if (wanted.texture) {
+        return;
+    }
+
+    // A screen showing the same image as a resident one shares its texture
+    wanted.texture = residentTexture(screen);
+    if (wanted.texture) {
+        wanted.sprite.setTexture(*wanted.texture, true);
+        fit(windowSize);
+        return;
+    }
+
+    wanted.asset = assets.loadImage(wanted.name, wanted.description, wanted.size);
+    if (assets.isReady(wanted.asset)) {
+        upload(screen);
+        releaseIfUnused(wanted.asset);
+    }
+}
+
+void BackgroundResidency::assetFinished(int asset) {
+    for (int i = 0; i < static_cast<int>(screens.size()); ++i) {
+        if (screens[i].asset == asset && !screens[i].texture && isWanted(i) && assets.isReady(asset)) {
+            upload(i);
+        }
+    }
+    releaseIfUnused(asset);
+}
+
+void BackgroundResidency::upload(int screen) {
+    Screen& uploaded = screens[screen];
+    uploaded.texture = textures.acquire(uploaded.description, assets.contentHash(uploaded.asset), assets.image(uploaded.asset));
+    if (uploaded.texture) {
+        uploaded.sprite.setTexture(*uploaded.texture, true);
+        fit(windowSize);
+    }
+}
+
+void BackgroundResidency::evict(int screen) {
+    screens[screen].texture.reset();
+    if (screens[screen].asset >= 0) {
+        releaseIfUnused(screens[screen].asset);
+    }
+}
+
+void BackgroundResidency::releaseIfUnused(int asset) {
+    for (int i = 0; i < static_cast<int>(screens.size()); ++i) {
+        if (screens[i].asset == asset && !screens[i].texture && isWanted(i)) {
+            return;
+        }
+    }
+    assets.release(asset);
+}
+
+bool BackgroundResidency::isResident(int screen) const {
+    return screens[screen].texture != nullptr;
+}
+
+void BackgroundResidency::fit(sf::Vector2u size) {
+    windowSize = size;
+    for (Screen& screen : screens) {
+        if (screen.texture) {
+            screen.sprite.setScale(
+                static_cast<float>(windowSize.x) / screen.texture->getSize().x,
+                static_cast<float>(windowSize.y) / screen.texture->getSize().y
+            );
+        }
+    }
+}
+
+void BackgroundResidency::draw(sf::RenderTarget& target) const {
+    if (current >= 0 && screens[current].texture) {
+        target.draw(screens[current].sprite);
+    }
+}
+
+size_t BackgroundResidency::gpuBytes() const {
+    // Screens sharing a texture count it once
+    size_t total = 0;
+    for (size_t i = 0; i < screens.size(); ++i) {
+        bool counted = false;
+        for (size_t j = 0; j < i; ++j) {
+            counted = counted || (screens[i].texture && screens[j].texture == screens[i].texture);
+        }
+        if (screens[i].texture && !counted) {
+            total += static_cast<size_t>(screens[i].texture->getSize().x) * screens[i].texture->getSize().y * 4;
+        }
+    }
+    return total;
+}
+
+void BackgroundResidency::report(std::ostream& out) const {
+    for (size_t i = 0; i < screens.size(); ++i) {
+        const Screen& screen = screens[i];
+        const char* state = screen.texture ? "resident" : isWanted(static_cast<int>(i)) ? "loading" : "evicted";
+        out << (static_cast<int>(i) == current ? "> " : "  ") << screen.description << ": " << state << "\n";
+    }
+    out << "  GPU " << gpuBytes() / 1024 << " / " << gpuBudget / 1024 << " KiB, decoded images "
+        << assets.decodedBytes() / 1024 << " / " << cpuBudget / 1024 << " KiB" << std::endl;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "AssetLoader.h"
+#include "TextureManager.h"
+
+// Keeps only the backgrounds the player can see soon in memory. Each screen
+// (the title, then every level) has one background. The current screen's
+// background is resident, the next screen's is decoded and uploaded ahead
+// of time, and every other one is evicted. Decoded pixels are freed as soon
+// as they are on the GPU.
+//
+// Prefetching is skipped while it would push GPU textures or decoded images
+// over their budgets; the background then loads when its screen is entered.
+class BackgroundResidency {
+public:
+    BackgroundResidency(AssetLoader& assets, TextureManager& textures, size_t gpuBudget, size_t cpuBudget);
+
+    // Background image of a screen, decoded at the given size when needed
+    void addScreen(const std::string& name, const std::string& description, sf::Vector2u size);
+
+    // Make a screen current: keep its background, prefetch the next screen's
+    // and evict the rest
+    void enterScreen(int screen);
+
+    // Upload a background the loader finished decoding; call for every asset from takeFinished
+    void assetFinished(int asset);
+
+    // Retry a prefetch held back by the budgets; call once per frame
+    void update();
+
+    // Whether the screen's background is on the GPU
+    bool isResident(int screen) const;
+
+    // Stretch the backgrounds over a window of the given size
+    void fit(sf::Vector2u windowSize);
+
+    // Draw the current screen's background, if it is resident
+    void draw(sf::RenderTarget& target) const;
+
+    // GPU memory taken by resident backgrounds
+    size_t gpuBytes() const;
+
+    // Print each screen's state and the memory used against the budgets
+    void report(std::ostream& out) const;
+
+private:
+    // One screen's background
+    struct Screen {
+        std::string name;                     // Asset name of the image
+        std::string description;
+        sf::Vector2u size;                    // Size the image is decoded at
+        int asset = -1;                       // Loader id, once requested
+        std::shared_ptr<const sf::Texture> texture;
+        sf::Sprite sprite;
+    };
+
+    // Whether a screen's background should be resident
+    bool isWanted(int screen) const;
+
+    // Bytes a screen's background takes once decoded or uploaded
+    size_t imageBytes(int screen) const;
+
+    // Texture already resident for the same image as a screen's background, or null
+    std::shared_ptr<const sf::Texture> residentTexture(int screen) const;
+
+    // Make a screen's background resident, from a live texture with the same content or a decode
+    void request(int screen);
+
+    // Upload a screen's decoded background
+    void upload(int screen);
+
+    // Drop a screen's texture, and its decoded image if no wanted screen needs it
+    void evict(int screen);
+
+    // Free the decoded image of an asset once no wanted screen is waiting on it
+    void releaseIfUnused(int asset);
+
+    AssetLoader& assets;
+    TextureManager& textures;
+    size_t gpuBudget;
+    size_t cpuBudget;
+    std::vector<Screen> screens;
+    sf::Vector2u windowSize;
+    int current = -1;                         // Screen being shown
+    bool prefetchDeferred = false;            // The next screen's prefetch waits on the budget
+};
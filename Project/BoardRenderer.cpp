@@ -0,0 +1,187 @@
+#include "BoardRenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+const unsigned ATLAS_PADDING = 2;             // Gap between frames so filtering never bleeds
+const unsigned SOLID_SIZE = 4;                // Size of the white block used for shadows
+const float SHADOW_OFFSET = 10.f;             // Shadow offset from its card
+const sf::Color SHADOW_COLOR(0, 0, 0, 150);   // Semi-transparent black with more opacity
+const size_t VERTICES_PER_QUAD = 6;
+const int FLIP_ANIMATION_MS = 150;            // Time to turn a card over
+
+bool BoardRenderer::loadAtlas(const sf::Image& backImage, const std::vector<const sf::Image*>& faceImages) {
+    // Every frame gets a cell as large as the largest image
+    unsigned cellWidth = backImage.getSize().x;
+    unsigned cellHeight = backImage.getSize().y;
+    for (const sf::Image* face : faceImages) {
+        cellWidth = std::max(cellWidth, face->getSize().x);
+        cellHeight = std::max(cellHeight, face->getSize().y);
+    }
+    cellWidth += ATLAS_PADDING;
+    cellHeight += ATLAS_PADDING;
+
+    // Back, faces and the solid block, laid out on a near-square grid
+    unsigned frameCount = static_cast<unsigned>(faceImages.size()) + 2;
+    unsigned columns = static_cast<unsigned>(std::ceil(std::sqrt(static_cast<float>(frameCount))));
+    unsigned rows = (frameCount + columns - 1) / columns;
+
+    sf::Image atlasImage;
+    atlasImage.create(columns * cellWidth, rows * cellHeight, sf::Color::Transparent);
+
+    auto place = [&](unsigned frame, const sf::Image& image) {
+        unsigned x = (frame % columns) * cellWidth;
+        unsigned y = (frame / columns) * cellHeight;
+        atlasImage.copy(image, x, y);
+        return sf::FloatRect(static_cast<float>(x), static_cast<float>(y), static_cast<float>(image.getSize().x), static_cast<float>(image.getSize().y));
+    };
+
+    backFrame = place(0, backImage);
+    faceFrames.clear();
+    for (unsigned i = 0; i < faceImages.size(); ++i) {
+        faceFrames.push_back(place(i + 1, *faceImages[i]));
+    }
+
+    sf::Image solid;
+    solid.create(SOLID_SIZE, SOLID_SIZE, sf::Color::White);
+    sf::FloatRect solidCell = place(frameCount - 1, solid);
+    // Sample only the centre of the block
+    solidFrame = sf::FloatRect(solidCell.left + 1.f, solidCell.top + 1.f, SOLID_SIZE - 2.f, SOLID_SIZE - 2.f);
+
+    useBuffer = sf::VertexBuffer::isAvailable();
+    return atlas.loadFromImage(atlasImage);
+}
+
+const sf::FloatRect& BoardRenderer::frameFor(int value, bool revealed) const {
+    if (!revealed || faceFrames.empty()) {
+        return backFrame;
+    }
+    return faceFrames[(value - 1) % faceFrames.size()];
+}
+
+void BoardRenderer::writeQuad(BoardMesh& mesh, size_t first, float x, float y, float size, float widthScale, const sf::FloatRect& frame, sf::Color color) {
+    float inset = size * (1.f - widthScale) / 2.f;
+    float left = x + inset;
+    float right = x + size - inset;
+    sf::Vector2f topLeft(left, y), topRight(right, y), bottomRight(right, y + size), bottomLeft(left, y + size);
+    sf::Vector2f texTopLeft(frame.left, frame.top);
+    sf::Vector2f texTopRight(frame.left + frame.width, frame.top);
+    sf::Vector2f texBottomRight(frame.left + frame.width, frame.top + frame.height);
+    sf::Vector2f texBottomLeft(frame.left, frame.top + frame.height);
+
+    sf::Vertex* quad = &mesh.vertices[first];
+    quad[0] = sf::Vertex(topLeft, color, texTopLeft);
+    quad[1] = sf::Vertex(topRight, color, texTopRight);
+    quad[2] = sf::Vertex(bottomRight, color, texBottomRight);
+    quad[3] = sf::Vertex(topLeft, color, texTopLeft);
+    quad[4] = sf::Vertex(bottomRight, color, texBottomRight);
+    quad[5] = sf::Vertex(bottomLeft, color, texBottomLeft);
+}
+
+void BoardRenderer::upload(size_t first, size_t count) {
+    if (useBuffer && count > 0) {
+        buffer.update(&board.vertices[first], count, static_cast<unsigned>(first));
+    }
+}
+
+void BoardRenderer::writeCard(BoardMesh& mesh, int index, float progress) const {
+    // The card narrows to an edge and opens again showing its other side
+    float widthScale = std::abs(1.f - 2.f * progress);
+    bool showRevealed = (progress < 0.5f) != (mesh.shownRevealed[index] != 0);
+    const sf::FloatRect& frame = frameFor(mesh.values[index], showRevealed);
+
+    const GridLayout& layout = mesh.layout;
+    float x = layout.cardX(index);
+    float y = layout.cardY(index);
+    writeQuad(mesh, index * VERTICES_PER_QUAD, x + SHADOW_OFFSET, y + SHADOW_OFFSET, layout.cardSize, widthScale, solidFrame, SHADOW_COLOR);
+    writeQuad(mesh, (mesh.cardCount + index) * VERTICES_PER_QUAD, x, y, layout.cardSize, widthScale, frame, sf::Color::White);
+}
+
+void BoardRenderer::buildMesh(BoardMesh& mesh, const CardStore& cards, const GridLayout& layout) const {
+    mesh.layout = layout;
+    mesh.cardCount = cards.size();
+    mesh.vertices.resize(mesh.cardCount * 2 * VERTICES_PER_QUAD);
+    mesh.values = cards.values;
+    mesh.shownRevealed.assign(cards.revealed.begin(), cards.revealed.end());
+    mesh.flipPrevious.assign(mesh.cardCount, 1.f);
+    mesh.flipCurrent.assign(mesh.cardCount, 1.f);
+    mesh.animating.clear();
+
+    // Shadow quads fill the first half of the vertices, so they are drawn under every card
+    for (int i = 0; i < mesh.cardCount; ++i) {
+        writeCard(mesh, i, 1.f);
+    }
+}
+
+void BoardRenderer::uploadBoard() {
+    if (useBuffer) {
+        buffer.create(board.vertices.size());
+        upload(0, board.vertices.size());
+    }
+}
+
+void BoardRenderer::setBoard(const CardStore& cards, const GridLayout& layout) {
+    buildMesh(board, cards, layout);
+    uploadBoard();
+}
+
+void BoardRenderer::prepareBoard(const CardStore& cards, const GridLayout& layout) {
+    buildMesh(pending, cards, layout);
+}
+
+void BoardRenderer::commitBoard() {
+    std::swap(board, pending);
+    uploadBoard();
+}
+
+void BoardRenderer::update(const CardStore& cards, int elapsedMs) {
+    float step = static_cast<float>(elapsedMs) / FLIP_ANIMATION_MS;
+
+    // Advance running animations, dropping those that finished a tick ago
+    for (size_t n = 0; n < board.animating.size();) {
+        int i = board.animating[n];
+        if (board.flipPrevious[i] >= 1.f) {
+            board.animating[n] = board.animating.back();
+            board.animating.pop_back();
+            continue;
+        }
+        board.flipPrevious[i] = board.flipCurrent[i];
+        board.flipCurrent[i] = std::min(1.f, board.flipCurrent[i] + step);
+        ++n;
+    }
+
+    // Start an animation for every card turned over since the last tick
+    for (int i = 0; i < board.cardCount; ++i) {
+        if (cards.revealed[i] == board.shownRevealed[i]) {
+            continue;
+        }
+        board.shownRevealed[i] = cards.revealed[i];
+        if (std::find(board.animating.begin(), board.animating.end(), i) == board.animating.end()) {
+            board.animating.push_back(i);
+        }
+        board.flipPrevious[i] = 0.f;
+        board.flipCurrent[i] = std::min(1.f, step);
+    }
+}
+
+void BoardRenderer::draw(sf::RenderTarget& target, float alpha) {
+    if (board.vertices.empty()) {
+        return;
+    }
+
+    // Only cards that are mid-flip change geometry between frames
+    for (int i : board.animating) {
+        writeCard(board, i, board.flipPrevious[i] + (board.flipCurrent[i] - board.flipPrevious[i]) * alpha);
+        upload(i * VERTICES_PER_QUAD, VERTICES_PER_QUAD);
+        upload((board.cardCount + i) * VERTICES_PER_QUAD, VERTICES_PER_QUAD);
+    }
+
+    sf::RenderStates states(&atlas);
+    if (useBuffer) {
+        target.draw(buffer, states);
+    }
+    else {
+        target.draw(board.vertices.data(), board.vertices.size(), sf::Triangles, states);
+    }
+}
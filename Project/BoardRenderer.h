@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <SFML/Graphics.hpp>
+#include "engine/CardStore.h"
+#include "engine/Layout.h"
+
+// Draws a whole board in one draw call. The card back and all faces are
+// packed into a single atlas texture, and every shadow and card quad lives
+// in one vertex buffer; only cards that are mid-flip are rewritten.
+class BoardRenderer {
+public:
+    // Pack the back and the face images (face i shows value i + 1) into the atlas
+    bool loadAtlas(const sf::Image& backImage, const std::vector<const sf::Image*>& faceImages);
+
+    // Build the shadow and card quads for a board laid out on the given grid
+    void setBoard(const CardStore& cards, const GridLayout& layout);
+
+    // Build the quads for the next board on the CPU only. Does not touch the
+    // board being drawn or any GPU state, so it may run on a worker thread.
+    void prepareBoard(const CardStore& cards, const GridLayout& layout);
+
+    // Swap in the board built by prepareBoard and upload it; call on the drawing thread
+    void commitBoard();
+
+    // Advance flip animations by one simulation tick, starting one for every
+    // card whose revealed state changed since the last tick
+    void update(const CardStore& cards, int elapsedMs);
+
+    // Draw every shadow and card with a single draw call, interpolating
+    // flip animations by alpha between the last two ticks
+    void draw(sf::RenderTarget& target, float alpha);
+
+private:
+    // Vertices and animation state of one board
+    struct BoardMesh {
+        std::vector<sf::Vertex> vertices;     // Shadow quads for all cards, then card quads
+        std::vector<int> values;              // Value of each card, for picking its face
+        std::vector<uint8_t> shownRevealed;   // Revealed state each card is showing or flipping to
+        std::vector<float> flipPrevious;      // Flip progress of each card at the previous tick
+        std::vector<float> flipCurrent;       // Flip progress of each card at the latest tick
+        std::vector<int> animating;           // Cards with a flip animation running
+        GridLayout layout;
+        int cardCount = 0;
+    };
+
+    // Atlas rectangle for the card back or the face of a value
+    const sf::FloatRect& frameFor(int value, bool revealed) const;
+
+    // Write the six vertices of one quad, squeezed horizontally about its centre by widthScale
+    static void writeQuad(BoardMesh& mesh, size_t first, float x, float y, float size, float widthScale, const sf::FloatRect& frame, sf::Color color);
+
+    // Write the shadow and card quads of one card at the given flip progress
+    void writeCard(BoardMesh& mesh, int index, float progress) const;
+
+    // Fill a mesh with the quads of a board
+    void buildMesh(BoardMesh& mesh, const CardStore& cards, const GridLayout& layout) const;
+
+    // Upload vertices [first, first + count) to the GPU buffer
+    void upload(size_t first, size_t count);
+
+    // Recreate the GPU buffer for the board being drawn
+    void uploadBoard();
+
+    sf::Texture atlas;
+    sf::FloatRect backFrame;                  // Atlas rectangle of the card back
+    std::vector<sf::FloatRect> faceFrames;    // Atlas rectangle of each face
+    sf::FloatRect solidFrame;                 // Plain white texels used for shadows
+
+    BoardMesh board;                          // Board being drawn
+    BoardMesh pending;                        // Next board, built by prepareBoard
+    sf::VertexBuffer buffer{ sf::Triangles, sf::VertexBuffer::Static };
+    bool useBuffer = false;                   // Vertex buffers are not supported on every GPU
+};
@@ -0,0 +1,52 @@
+#include "FrameLoop.h"
+
+#include <algorithm>
+#include <thread>
+
+// Longest stretch of real time simulated in one frame, so a stall does not
+// turn into a burst of catch-up ticks
+const sf::Int64 MAX_FRAME_US = 250000;
+
+// Sleep this much short of a deadline and yield for the rest, since
+// sleeps routinely overshoot by a millisecond or more
+const sf::Int64 SLEEP_MARGIN_US = 2000;
+
+FixedStepClock::FixedStepClock(int stepMs) : stepUs(stepMs * 1000) {
+}
+
+int FixedStepClock::beginFrame() {
+    accumulatorUs += std::min(clock.restart().asMicroseconds(), MAX_FRAME_US);
+    int ticks = static_cast<int>(accumulatorUs / stepUs);
+    accumulatorUs -= ticks * stepUs;
+    return ticks;
+}
+
+float FixedStepClock::alpha() const {
+    return static_cast<float>(accumulatorUs) / static_cast<float>(stepUs);
+}
+
+void FixedStepClock::reset() {
+    clock.restart();
+    accumulatorUs = 0;
+}
+
+FramePacer::FramePacer(int framesPerSecond) : periodUs(1000000 / framesPerSecond) {
+}
+
+void FramePacer::waitForNextFrame() {
+    nextFrameUs += periodUs;
+    sf::Int64 nowUs = clock.getElapsedTime().asMicroseconds();
+
+    // A frame that missed its deadline by more than a period starts a new schedule
+    if (nowUs > nextFrameUs + periodUs) {
+        nextFrameUs = nowUs;
+        return;
+    }
+
+    if (nextFrameUs - nowUs > SLEEP_MARGIN_US) {
+        sf::sleep(sf::microseconds(nextFrameUs - nowUs - SLEEP_MARGIN_US));
+    }
+    while (clock.getElapsedTime().asMicroseconds() < nextFrameUs) {
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <SFML/System.hpp>
+
+// Fixed-timestep clock. Real time is accumulated each frame and handed out
+// as whole simulation ticks, so game timers advance in identical steps no
+// matter how fast frames are drawn. The leftover fraction of a tick is used
+// to interpolate rendering between the last two simulated states.
+class FixedStepClock {
+public:
+    explicit FixedStepClock(int stepMs);
+
+    // Measure the time since the last frame and return how many ticks to simulate
+    int beginFrame();
+
+    // Fraction of a tick accumulated but not yet simulated, in [0, 1)
+    float alpha() const;
+
+    // Drop accumulated time, e.g. after a stall that should not be caught up
+    void reset();
+
+private:
+    sf::Clock clock;
+    sf::Int64 stepUs;
+    sf::Int64 accumulatorUs = 0;
+};
+
+// Deadline-based frame pacer. Frames are scheduled on a fixed grid of
+// absolute deadlines instead of sleeping a relative amount after each frame,
+// so sleep overshoot does not accumulate into drift or uneven frame times.
+class FramePacer {
+public:
+    explicit FramePacer(int framesPerSecond);
+
+    // Block until the next frame deadline
+    void waitForNextFrame();
+
+private:
+    sf::Clock clock;
+    sf::Int64 periodUs;
+    sf::Int64 nextFrameUs = 0;
+};
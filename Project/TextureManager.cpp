@@ -0,0 +1,74 @@
+#include "TextureManager.h"
+
+#include <algorithm>
+#include <iomanip>
+
+std::shared_ptr<const sf::Texture> TextureManager::acquire(const std::string& name, uint64_t contentHash, const sf::Image& image) {
+    Entry& entry = entries[contentHash];
+    if (std::find(entry.names.begin(), entry.names.end(), name) == entry.names.end()) {
+        entry.names.push_back(name);
+    }
+    if (auto shared = entry.texture.lock()) {
+        return shared;
+    }
+
+    auto texture = std::make_shared<sf::Texture>();
+    if (!texture->loadFromImage(image)) {
+        entries.erase(contentHash);
+        return nullptr;
+    }
+    entry.texture = texture;
+    entry.size = texture->getSize();
+    return texture;
+}
+
+std::shared_ptr<const sf::Texture> TextureManager::find(uint64_t contentHash) const {
+    auto it = entries.find(contentHash);
+    return it == entries.end() ? nullptr : it->second.texture.lock();
+}
+
+void TextureManager::prune() const {
+    for (auto it = entries.begin(); it != entries.end();) {
+        if (it->second.texture.expired()) {
+            it = entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+std::vector<TextureManager::Resident> TextureManager::resident() const {
+    prune();
+    std::vector<Resident> result;
+    for (const auto& item : entries) {
+        const Entry& entry = item.second;
+        size_t bytes = static_cast<size_t>(entry.size.x) * entry.size.y * 4;
+        result.push_back({ item.first, entry.size, bytes, entry.texture.use_count(), entry.names });
+    }
+    std::sort(result.begin(), result.end(), [](const Resident& a, const Resident& b) { return a.bytes > b.bytes; });
+    return result;
+}
+
+size_t TextureManager::residentBytes() const {
+    size_t total = 0;
+    for (const Resident& texture : resident()) {
+        total += texture.bytes;
+    }
+    return total;
+}
+
+void TextureManager::report(std::ostream& out) const {
+    std::vector<Resident> textures = resident();
+    size_t total = 0;
+    for (const Resident& texture : textures) {
+        total += texture.bytes;
+        out << std::setw(8) << (texture.bytes + 1023) / 1024 << " KiB  "
+            << texture.size.x << "x" << texture.size.y << "  ";
+        for (size_t i = 0; i < texture.names.size(); ++i) {
+            out << (i > 0 ? ", " : "") << texture.names[i];
+        }
+        out << " (" << texture.handles << (texture.handles == 1 ? " handle)" : " handles)") << "\n";
+    }
+    out << std::setw(8) << (total + 1023) / 1024 << " KiB  total in " << textures.size() << " textures" << std::endl;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <SFML/Graphics.hpp>
+
+// Hands out GPU textures shared by content. Images are identified by a hash
+// of their content (see AssetLoader::contentHash), so the same picture
+// loaded under several names or for several screens is uploaded once.
+// A texture stays resident while any handle to it is alive.
+class TextureManager {
+public:
+    // Texture for the image's content, uploading it only if no live texture has
+    // the same content; name is recorded for the residency report. Returns null
+    // if the upload fails.
+    std::shared_ptr<const sf::Texture> acquire(const std::string& name, uint64_t contentHash, const sf::Image& image);
+
+    // Live texture with the given content, or null if none is resident
+    std::shared_ptr<const sf::Texture> find(uint64_t contentHash) const;
+
+    // One resident texture and the assets sharing it
+    struct Resident {
+        uint64_t contentHash;
+        sf::Vector2u size;
+        size_t bytes;                         // GPU memory taken, at 4 bytes per texel
+        long handles;                         // Live handles to the texture
+        std::vector<std::string> names;       // Assets that acquired it
+    };
+
+    // Textures currently resident, largest first
+    std::vector<Resident> resident() const;
+
+    // Total GPU memory taken by resident textures
+    size_t residentBytes() const;
+
+    // Print resident textures and the bytes each takes
+    void report(std::ostream& out) const;
+
+private:
+    struct Entry {
+        std::weak_ptr<const sf::Texture> texture;
+        sf::Vector2u size;
+        std::vector<std::string> names;
+    };
+
+    // Forget textures whose last handle was released
+    void prune() const;
+
+    mutable std::unordered_map<uint64_t, Entry> entries;
+};
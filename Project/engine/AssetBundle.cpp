@@ -0,0 +1,136 @@
+#include "AssetBundle.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include "ByteOrder.h"
+
+const char BUNDLE_MAGIC[4] = { 'M', 'M', 'A', 'B' };
+const uint32_t BUNDLE_VERSION = 1;
+const size_t BUNDLE_HEADER_SIZE = 16;
+const uint64_t BUNDLE_ALIGNMENT = 16;
+
+bool AssetBundle::open(const std::string& path) {
+    entries.clear();
+    if (!file.open(path)) {
+        return false;
+    }
+
+    const unsigned char* data = file.data();
+    size_t size = file.size();
+    if (size < BUNDLE_HEADER_SIZE || std::memcmp(data, BUNDLE_MAGIC, 4) != 0 || readLittleEndian(data + 4, 4) != BUNDLE_VERSION) {
+        file.close();
+        return false;
+    }
+
+    uint64_t count = readLittleEndian(data + 8, 4);
+    uint64_t indexSize = readLittleEndian(data + 12, 4);
+    if (BUNDLE_HEADER_SIZE + indexSize > size) {
+        file.close();
+        return false;
+    }
+
+    const unsigned char* cursor = data + BUNDLE_HEADER_SIZE;
+    const unsigned char* indexEnd = cursor + indexSize;
+    for (uint64_t i = 0; i < count; ++i) {
+        if (indexEnd - cursor < 18) {
+            file.close();
+            entries.clear();
+            return false;
+        }
+        Entry entry;
+        entry.offset = readLittleEndian(cursor, 8);
+        entry.size = readLittleEndian(cursor + 8, 8);
+        size_t nameLength = static_cast<size_t>(readLittleEndian(cursor + 16, 2));
+        cursor += 18;
+        if (static_cast<size_t>(indexEnd - cursor) < nameLength || entry.offset > size || entry.size > size - entry.offset) {
+            file.close();
+            entries.clear();
+            return false;
+        }
+        entries[std::string(reinterpret_cast<const char*>(cursor), nameLength)] = entry;
+        cursor += nameLength;
+    }
+
+    // Startup reads most of the bundle, so fetch it in one sequential pass
+    file.prefetch();
+    return true;
+}
+
+const void* AssetBundle::find(const std::string& name, size_t& size) const {
+    auto it = entries.find(name);
+    if (it == entries.end()) {
+        size = 0;
+        return nullptr;
+    }
+    size = static_cast<size_t>(it->second.size);
+    return file.data() + it->second.offset;
+}
+
+std::vector<std::string> AssetBundle::names() const {
+    std::vector<std::string> result;
+    for (const auto& entry : entries) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+bool writeAssetBundle(const std::string& path, const std::vector<std::pair<std::string, std::string>>& sources, std::string& error) {
+    // Read every source up front so the index can be written before the data
+    std::vector<std::string> contents;
+    for (const auto& source : sources) {
+        std::ifstream in(source.second, std::ios::binary);
+        if (!in) {
+            error = "cannot read " + source.second;
+            return false;
+        }
+        contents.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        if (source.first.size() > 0xFFFF) {
+            error = "entry name too long: " + source.first;
+            return false;
+        }
+    }
+
+    uint64_t indexSize = 0;
+    for (const auto& source : sources) {
+        indexSize += 18 + source.first.size();
+    }
+
+    std::string index;
+    uint64_t offset = BUNDLE_HEADER_SIZE + indexSize;
+    std::vector<uint64_t> offsets;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        offset = (offset + BUNDLE_ALIGNMENT - 1) / BUNDLE_ALIGNMENT * BUNDLE_ALIGNMENT;
+        offsets.push_back(offset);
+        writeLittleEndian(index, offset, 8);
+        writeLittleEndian(index, contents[i].size(), 8);
+        writeLittleEndian(index, sources[i].first.size(), 2);
+        index += sources[i].first;
+        offset += contents[i].size();
+    }
+
+    std::string header(BUNDLE_MAGIC, 4);
+    writeLittleEndian(header, BUNDLE_VERSION, 4);
+    writeLittleEndian(header, sources.size(), 4);
+    writeLittleEndian(header, indexSize, 4);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    out << header << index;
+
+    uint64_t written = BUNDLE_HEADER_SIZE + indexSize;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        out << std::string(static_cast<size_t>(offsets[i] - written), '\0');
+        out << contents[i];
+        written = offsets[i] + contents[i].size();
+    }
+
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "MappedFile.h"
+
+// Packed asset archive: every image, sound and font in one file, indexed by
+// name. The archive is memory-mapped and entries are handed out as pointers
+// into the mapping, so assets can be decoded with loadFromMemory without
+// opening or copying individual files.
+//
+// Layout (little-endian):
+//   header   "MMAB", uint32 version, uint32 entry count, uint32 index size
+//   index    per entry: uint64 offset, uint64 size, uint16 name length, name bytes
+//   data     entry contents, each starting on a 16-byte boundary
+class AssetBundle {
+public:
+    // Map a bundle and read its index; returns false when missing or malformed
+    bool open(const std::string& path);
+
+    bool isOpen() const {
+        return file.isOpen();
+    }
+
+    // Bytes of the named entry, or nullptr when the bundle has no such entry
+    const void* find(const std::string& name, size_t& size) const;
+
+    // Names of all entries
+    std::vector<std::string> names() const;
+
+private:
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    MappedFile file;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+// Write a bundle holding the given (entry name, source file path) pairs;
+// returns false and fills error when a source cannot be read or the output written
+bool writeAssetBundle(const std::string& path, const std::vector<std::pair<std::string, std::string>>& sources, std::string& error);
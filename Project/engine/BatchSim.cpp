@@ -0,0 +1,205 @@
+#include "BatchSim.h"
+
+#include <algorithm>
+#include "CardStore.h"
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+void BoardBatch::deal(int boardCount, int boardPairs, Rng& rng) {
+    pairs = boardPairs;
+    count = boardCount;
+    // Room for a 4-byte gather at the last card
+    stride = (2 * pairs + 3 + 3) & ~3;
+    // Padding is never compared, so the old buffer is reused as it is
+    values.resize(static_cast<size_t>(count) * stride);
+    dealBoards(values.data(), count, stride, pairs, rng);
+}
+
+// Play count boards laid out stride bytes apart from values
+static void playBoardsScalar(const uint8_t* values, int count, int stride, int pairs, int* moves) {
+    for (int b = 0; b < count; ++b) {
+        const uint8_t* board = values + static_cast<size_t>(b) * stride;
+        uint32_t seen = 0;                // Values with one card known
+        int known = 0;                    // Pairs with both cards known, not yet taken
+        int matched = 0;
+        int cursor = 0;                   // Next unseen card
+        int count = 0;
+
+        while (matched < pairs) {
+            count++;
+            if (known > 0) {
+                known--;
+                matched++;
+                continue;
+            }
+            uint32_t first = 1u << (board[cursor++] - 1);
+            if (seen & first) {
+                seen &= ~first;           // Its partner is remembered: a match
+                matched++;
+                continue;
+            }
+            uint32_t second = 1u << (board[cursor++] - 1);
+            if (second == first) {
+                matched++;                // Lucky match of two unseen cards
+            }
+            else if (seen & second) {
+                seen &= ~second;          // Mismatch that completes a known pair
+                known++;
+                seen |= first;
+            }
+            else {
+                seen |= first | second;
+            }
+        }
+        moves[b] = count;
+    }
+}
+
+void playBatchScalar(const BoardBatch& batch, int* moves) {
+    playBoardsScalar(batch.values.data(), batch.count, batch.stride, batch.pairs, moves);
+}
+
+#if defined(__AVX512F__)
+
+int batchLaneCount() {
+    return 16;
+}
+
+void playBatch(const BoardBatch& batch, int* moves) {
+    const __m512i one = _mm512_set1_epi32(1);
+    const __m512i zero = _mm512_setzero_si512();
+    const __m512i byteMask = _mm512_set1_epi32(0xFF);
+    const __m512i pairs = _mm512_set1_epi32(batch.pairs);
+    // Lanes gather relative to their group's first board, so the 32-bit
+    // offsets stay small however large the batch
+    const __m512i laneStart = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(batch.stride));
+
+    int full = batch.count / 16 * 16;
+    for (int first = 0; first < full; first += 16) {
+        const int* base = reinterpret_cast<const int*>(batch.values.data() + static_cast<size_t>(first) * batch.stride);
+        __m512i cursor = laneStart;
+        __m512i seen = zero, known = zero, matched = zero, count = zero;
+
+        // Lanes that still have pairs to find
+        __mmask16 active = _mm512_cmplt_epi32_mask(matched, pairs);
+        while (active) {
+            count = _mm512_mask_add_epi32(count, active, count, one);
+
+            // Take a known pair
+            __mmask16 takeKnown = _mm512_mask_cmpgt_epi32_mask(active, known, zero);
+            known = _mm512_mask_sub_epi32(known, takeKnown, known, one);
+            matched = _mm512_mask_add_epi32(matched, takeKnown, matched, one);
+
+            // Turn over the next unseen card
+            __mmask16 explore = active & ~takeKnown;
+            __m512i firstValue = _mm512_and_si512(_mm512_mask_i32gather_epi32(zero, explore, cursor, base, 1), byteMask);
+            __m512i firstBit = _mm512_sllv_epi32(one, _mm512_sub_epi32(firstValue, one));
+            cursor = _mm512_mask_add_epi32(cursor, explore, cursor, one);
+            __mmask16 partnerKnown = _mm512_mask_test_epi32_mask(explore, seen, firstBit);
+            seen = _mm512_mask_andnot_epi32(seen, partnerKnown, firstBit, seen);
+            matched = _mm512_mask_add_epi32(matched, partnerKnown, matched, one);
+
+            // Its partner is unknown: turn over a second unseen card
+            __mmask16 second = explore & ~partnerKnown;
+            __m512i secondValue = _mm512_and_si512(_mm512_mask_i32gather_epi32(zero, second, cursor, base, 1), byteMask);
+            __m512i secondBit = _mm512_sllv_epi32(one, _mm512_sub_epi32(secondValue, one));
+            cursor = _mm512_mask_add_epi32(cursor, second, cursor, one);
+            __mmask16 lucky = _mm512_mask_cmpeq_epi32_mask(second, firstValue, secondValue);
+            matched = _mm512_mask_add_epi32(matched, lucky, matched, one);
+            __mmask16 completes = _mm512_mask_test_epi32_mask(second & ~lucky, seen, secondBit);
+            known = _mm512_mask_add_epi32(known, completes, known, one);
+            seen = _mm512_mask_andnot_epi32(seen, completes, secondBit, seen);
+            seen = _mm512_mask_or_epi32(seen, second & ~lucky, seen, firstBit);
+            seen = _mm512_mask_or_epi32(seen, second & ~lucky & ~completes, seen, secondBit);
+
+            active = _mm512_cmplt_epi32_mask(matched, pairs);
+        }
+        _mm512_storeu_si512(moves + first, count);
+    }
+
+    // Boards left over after the last full set of lanes, played where they lie
+    playBoardsScalar(batch.values.data() + static_cast<size_t>(full) * batch.stride, batch.count - full, batch.stride, batch.pairs, moves + full);
+}
+
+#elif defined(__AVX2__)
+
+int batchLaneCount() {
+    return 8;
+}
+
+void playBatch(const BoardBatch& batch, int* moves) {
+    const __m256i one = _mm256_set1_epi32(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i pairs = _mm256_set1_epi32(batch.pairs);
+    // Lanes gather relative to their group's first board, so the 32-bit
+    // offsets stay small however large the batch
+    const __m256i laneStart = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(batch.stride));
+
+    // Masks are all-ones lanes; blendv picks the updated value where the mask is set
+    auto where = [](__m256i mask, __m256i updated, __m256i current) {
+        return _mm256_blendv_epi8(current, updated, mask);
+    };
+    auto test = [&](__m256i mask, __m256i bits, __m256i bit) {
+        return _mm256_andnot_si256(_mm256_cmpeq_epi32(_mm256_and_si256(bits, bit), zero), mask);
+    };
+
+    int full = batch.count / 8 * 8;
+    for (int first = 0; first < full; first += 8) {
+        const int* base = reinterpret_cast<const int*>(batch.values.data() + static_cast<size_t>(first) * batch.stride);
+        __m256i cursor = laneStart;
+        __m256i seen = zero, known = zero, matched = zero, count = zero;
+
+        __m256i active = _mm256_cmpgt_epi32(pairs, matched);
+        while (!_mm256_testz_si256(active, active)) {
+            count = _mm256_sub_epi32(count, active);
+
+            // Take a known pair
+            __m256i takeKnown = _mm256_and_si256(active, _mm256_cmpgt_epi32(known, zero));
+            known = _mm256_add_epi32(known, takeKnown);
+            matched = _mm256_sub_epi32(matched, takeKnown);
+
+            // Turn over the next unseen card
+            __m256i explore = _mm256_andnot_si256(takeKnown, active);
+            __m256i firstValue = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, base, cursor, explore, 1), byteMask);
+            __m256i firstBit = _mm256_sllv_epi32(one, _mm256_sub_epi32(firstValue, one));
+            cursor = _mm256_sub_epi32(cursor, explore);
+            __m256i partnerKnown = test(explore, seen, firstBit);
+            seen = where(partnerKnown, _mm256_andnot_si256(firstBit, seen), seen);
+            matched = _mm256_sub_epi32(matched, partnerKnown);
+
+            // Its partner is unknown: turn over a second unseen card
+            __m256i second = _mm256_andnot_si256(partnerKnown, explore);
+            __m256i secondValue = _mm256_and_si256(_mm256_mask_i32gather_epi32(zero, base, cursor, second, 1), byteMask);
+            __m256i secondBit = _mm256_sllv_epi32(one, _mm256_sub_epi32(secondValue, one));
+            cursor = _mm256_sub_epi32(cursor, second);
+            __m256i lucky = _mm256_and_si256(second, _mm256_cmpeq_epi32(firstValue, secondValue));
+            matched = _mm256_sub_epi32(matched, lucky);
+            __m256i mismatch = _mm256_andnot_si256(lucky, second);
+            __m256i completes = test(mismatch, seen, secondBit);
+            known = _mm256_sub_epi32(known, completes);
+            seen = where(completes, _mm256_andnot_si256(secondBit, seen), seen);
+            seen = where(mismatch, _mm256_or_si256(seen, firstBit), seen);
+            seen = where(_mm256_andnot_si256(completes, mismatch), _mm256_or_si256(seen, secondBit), seen);
+
+            active = _mm256_cmpgt_epi32(pairs, matched);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(moves + first), count);
+    }
+
+    // Boards left over after the last full set of lanes, played where they lie
+    playBoardsScalar(batch.values.data() + static_cast<size_t>(full) * batch.stride, batch.count - full, batch.stride, batch.pairs, moves + full);
+}
+
+#else
+
+int batchLaneCount() {
+    return 1;
+}
+
+void playBatch(const BoardBatch& batch, int* moves) {
+    playBatchScalar(batch, moves);
+}
+
+#endif
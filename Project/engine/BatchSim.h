@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Random.h"
+
+// Plays many boards side by side in SIMD lanes, one board per lane, with the
+// perfect-memory strategy: take any pair whose both cards are known,
+// otherwise turn over the next unseen card and complete its pair from memory
+// when possible. Unseen cards are turned over in board order, which on a
+// shuffled board is the same as choosing one at random.
+//
+// Each move reveals two cards and compares their values exactly as
+// resolveFlipped does; only the counts the strategy needs are kept, so a
+// lane's whole memory is a bitmask of the values seen once.
+//
+// Builds with AVX-512 use 16 lanes, AVX2 builds 8, and anything else the
+// scalar loop, which is also the reference the vector paths must match.
+
+// Most pairs a batch board can hold: one bit per value in a 32-bit lane
+const int BATCH_MAX_PAIRS = 32;
+
+// Boards dealt into one packed array of card values
+struct BoardBatch {
+    int pairs = 0;
+    int count = 0;                        // Number of boards
+    int stride = 0;                       // Bytes per board, padded for vector loads
+    std::vector<uint8_t> values;          // Card values of board b at [b * stride, b * stride + 2 * pairs)
+
+    // Deal count shuffled boards of the given size
+    void deal(int boardCount, int boardPairs, Rng& rng);
+};
+
+// Number of lanes the vector path of this build runs; 1 for the scalar build
+int batchLaneCount();
+
+// Play every board and write its move count to moves[board]; vector path when built with one
+void playBatch(const BoardBatch& batch, int* moves);
+
+// Play every board one at a time with the same strategy
+void playBatchScalar(const BoardBatch& batch, int* moves);
@@ -0,0 +1,132 @@
+#include "Bitboard.h"
+
+#include "Random.h"
+
+uint64_t Bitboard::knownPairs() const {
+    uint64_t candidates = faceDown() & known;
+    uint64_t pairs = 0;
+    while (candidates != 0) {
+        int index = lowestBit(candidates);
+        uint64_t sameValue = withValue(value(index)) & candidates;
+        if (popCount(sameValue) == 2) {
+            pairs |= sameValue;
+        }
+        candidates &= ~sameValue;
+    }
+    return pairs;
+}
+
+int generateMoves(const Bitboard& board, BitboardMove* moves) {
+    int count = 0;
+    uint64_t faceDown = board.faceDown();
+    uint64_t knownFaceDown = faceDown & board.known;
+
+    // Known pairs
+    uint64_t pairs = board.knownPairs();
+    while (pairs != 0) {
+        int first = lowestBit(pairs);
+        uint64_t partner = board.withValue(board.value(first)) & pairs & ~(1ull << first);
+        moves[count++] = { static_cast<uint8_t>(first), static_cast<uint8_t>(lowestBit(partner)) };
+        pairs &= ~(partner | (1ull << first));
+    }
+
+    // An unseen card is turned over first; the second card is chosen after
+    // seeing it, so a known partner is taken if there is one
+    forEachBit(board.unseen(), [&](int first) {
+        uint64_t partner = board.withValue(board.value(first)) & knownFaceDown;
+        if (partner != 0) {
+            moves[count++] = { static_cast<uint8_t>(first), static_cast<uint8_t>(lowestBit(partner)) };
+            return;
+        }
+        // Pairs of unseen cards are listed once, from their lower card
+        forEachBit(faceDown & ~(1ull << first) & ~(board.unseen() & ((1ull << first) - 1)), [&](int second) {
+            moves[count++] = { static_cast<uint8_t>(first), static_cast<uint8_t>(second) };
+        });
+    });
+    return count;
+}
+
+bool applyMove(Bitboard& board, BitboardMove move) {
+    uint64_t cards = (1ull << move.first) | (1ull << move.second);
+    board.known |= cards;
+    if (board.value(move.first) != board.value(move.second)) {
+        return false;
+    }
+    board.revealed |= cards;
+    board.matched |= cards;
+    return true;
+}
+
+static ZobristKeys makeZobristKeys() {
+    ZobristKeys keys;
+    Rng rng(0x4D4D5A6F62726973ull);
+    for (int i = 0; i < BITBOARD_MAX_CARDS; ++i) {
+        keys.revealed[i] = rng.next();
+        keys.matched[i] = rng.next();
+        keys.known[i] = rng.next();
+        for (int v = 0; v < (1 << BITBOARD_VALUE_BITS); ++v) {
+            keys.value[i][v] = rng.next();
+        }
+    }
+    return keys;
+}
+
+const ZobristKeys& zobristKeys() {
+    static const ZobristKeys keys = makeZobristKeys();
+    return keys;
+}
+
+uint64_t zobristHash(const Bitboard& board) {
+    const ZobristKeys& keys = zobristKeys();
+    uint64_t hash = 0;
+    forEachBit(board.revealed, [&](int i) { hash ^= keys.revealed[i]; });
+    forEachBit(board.matched, [&](int i) { hash ^= keys.matched[i]; });
+    forEachBit(board.known, [&](int i) { hash ^= keys.known[i]; });
+    forEachBit(board.cardMask(), [&](int i) { hash ^= keys.value[i][board.value(i) - 1]; });
+    return hash;
+}
+
+uint64_t zobristAfterMove(uint64_t hash, const Bitboard& before, const Bitboard& after) {
+    // A move only sets bits, and never changes values
+    const ZobristKeys& keys = zobristKeys();
+    forEachBit(after.revealed & ~before.revealed, [&](int i) { hash ^= keys.revealed[i]; });
+    forEachBit(after.matched & ~before.matched, [&](int i) { hash ^= keys.matched[i]; });
+    forEachBit(after.known & ~before.known, [&](int i) { hash ^= keys.known[i]; });
+    return hash;
+}
+
+bool toBitboard(const CardStore& cards, Bitboard& board, uint64_t known) {
+    if (cards.size() > BITBOARD_MAX_CARDS) {
+        return false;
+    }
+    for (int value : cards.values) {
+        if (value < 1 || value > BITBOARD_MAX_VALUE) {
+            return false;
+        }
+    }
+
+    board = Bitboard();
+    board.cardCount = cards.size();
+    for (int i = 0; i < board.cardCount; ++i) {
+        board.setValue(i, cards.values[i]);
+        if (cards.revealed[i]) {
+            board.revealed |= 1ull << i;
+        }
+        if (cards.matched[i]) {
+            board.matched |= 1ull << i;
+        }
+    }
+    // Face-up cards are visible to the player
+    board.known = (known | board.revealed) & board.cardMask();
+    return true;
+}
+
+void fromBitboard(const Bitboard& board, CardStore& cards) {
+    cards.clear();
+    cards.reserve(board.cardCount);
+    for (int i = 0; i < board.cardCount; ++i) {
+        int index = cards.addCard(board.value(i));
+        cards.revealed[index] = static_cast<uint8_t>((board.revealed >> i) & 1);
+        cards.matched[index] = static_cast<uint8_t>((board.matched >> i) & 1);
+    }
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include "CardStore.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// Most cards a bitboard holds: one bit per card in each mask
+const int BITBOARD_MAX_CARDS = 64;
+
+// Bits per card value; values 1..32 are stored as value - 1
+const int BITBOARD_VALUE_BITS = 5;
+const int BITBOARD_MAX_VALUE = 1 << BITBOARD_VALUE_BITS;
+
+inline int popCount(uint64_t mask) {
+#if defined(_MSC_VER)
+    return static_cast<int>(__popcnt64(mask));
+#else
+    return __builtin_popcountll(mask);
+#endif
+}
+
+// Index of the lowest set bit; mask must not be zero
+inline int lowestBit(uint64_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward64(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+// Index of the highest set bit; mask must not be zero
+inline int highestBit(uint64_t mask) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanReverse64(&index, mask);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(mask);
+#endif
+}
+
+// Index of the set bit with n set bits below it; mask must have more than n bits set
+inline int nthBit(uint64_t mask, int n) {
+#if defined(__BMI2__)
+    return lowestBit(_pdep_u64(1ull << n, mask));
+#else
+    for (; n > 0; --n) {
+        mask &= mask - 1;
+    }
+    return lowestBit(mask);
+#endif
+}
+
+// Call f(index) for every set bit, lowest first
+template <typename F>
+inline void forEachBit(uint64_t mask, F f) {
+    while (mask != 0) {
+        f(lowestBit(mask));
+        mask &= mask - 1;
+    }
+}
+
+// Compact board for search: card state as 64-bit masks with bit i for card
+// i, and card values stored vertically, plane p holding bit p of every
+// card's value - 1, so the cards of one value are found with a few ANDs.
+// The whole board is nine words, cheap to copy at every search node.
+struct Bitboard {
+    int cardCount = 0;
+    uint64_t revealed = 0;                // Face up, including matched cards
+    uint64_t matched = 0;                 // Pair found
+    uint64_t known = 0;                   // Value seen by the player
+    uint64_t valuePlanes[BITBOARD_VALUE_BITS] = {};
+
+    uint64_t cardMask() const {
+        return cardCount == 64 ? ~0ull : (1ull << cardCount) - 1;
+    }
+
+    int value(int index) const {
+        int bits = 0;
+        for (int p = 0; p < BITBOARD_VALUE_BITS; ++p) {
+            bits |= static_cast<int>((valuePlanes[p] >> index) & 1) << p;
+        }
+        return bits + 1;
+    }
+
+    void setValue(int index, int value) {
+        for (int p = 0; p < BITBOARD_VALUE_BITS; ++p) {
+            uint64_t bit = 1ull << index;
+            valuePlanes[p] = ((value - 1) >> p) & 1 ? valuePlanes[p] | bit : valuePlanes[p] & ~bit;
+        }
+    }
+
+    // Cards with the given value
+    uint64_t withValue(int value) const {
+        uint64_t mask = cardMask();
+        for (int p = 0; p < BITBOARD_VALUE_BITS; ++p) {
+            mask &= ((value - 1) >> p) & 1 ? valuePlanes[p] : ~valuePlanes[p];
+        }
+        return mask;
+    }
+
+    uint64_t faceDown() const {
+        return cardMask() & ~revealed;
+    }
+
+    // Face-down cards the player has never seen
+    uint64_t unseen() const {
+        return faceDown() & ~known;
+    }
+
+    // Face-down cards whose partner is also known and face down
+    uint64_t knownPairs() const;
+
+    // Known face-down cards whose partner is still unseen
+    uint64_t knownSingletons() const {
+        return faceDown() & known & ~knownPairs();
+    }
+};
+
+// A move turns over two face-down cards
+struct BitboardMove {
+    uint8_t first;
+    uint8_t second;
+};
+
+// Most moves generateMoves can produce: every pair of 64 cards
+const int BITBOARD_MAX_MOVES = BITBOARD_MAX_CARDS * (BITBOARD_MAX_CARDS - 1) / 2;
+
+// Moves worth searching, each pair of cards once: every known pair, then
+// every unseen card with its known partner if any, or with each other
+// face-down card otherwise. Turning over two known non-matching cards
+// teaches nothing and is left out. Returns the number written to moves.
+int generateMoves(const Bitboard& board, BitboardMove* moves);
+
+// Turn over both cards of a move and compare them as resolveFlipped does:
+// a match stays face up, a mismatch is turned back but remembered.
+// Returns true on a match.
+bool applyMove(Bitboard& board, BitboardMove move);
+
+// Random keys for Zobrist hashing of board state, one per card per mask and per card per value
+struct ZobristKeys {
+    uint64_t revealed[BITBOARD_MAX_CARDS];
+    uint64_t matched[BITBOARD_MAX_CARDS];
+    uint64_t known[BITBOARD_MAX_CARDS];
+    uint64_t value[BITBOARD_MAX_CARDS][1 << BITBOARD_VALUE_BITS];
+};
+
+// Keys generated from a fixed seed, identical on every run and platform
+const ZobristKeys& zobristKeys();
+
+// Hash of a whole board, for transposition tables
+uint64_t zobristHash(const Bitboard& board);
+
+// Hash after applyMove, updated from the hash before it instead of recomputed
+uint64_t zobristAfterMove(uint64_t hash, const Bitboard& before, const Bitboard& after);
+
+// Convert from the game's card store; known marks the cards the player has
+// seen. Returns false, leaving board unchanged, when the store has more
+// than BITBOARD_MAX_CARDS cards or a value outside 1..BITBOARD_MAX_VALUE.
+bool toBitboard(const CardStore& cards, Bitboard& board, uint64_t known = 0);
+
+// Convert back to a card store, reusing its storage
+void fromBitboard(const Bitboard& board, CardStore& cards);
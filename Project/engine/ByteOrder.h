@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Little-endian field access for the engine's file formats, independent of the host byte order
+inline uint64_t readLittleEndian(const unsigned char* bytes, int width) {
+    uint64_t value = 0;
+    for (int i = width - 1; i >= 0; --i) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+inline void writeLittleEndian(std::string& out, uint64_t value, int width) {
+    for (int i = 0; i < width; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+// Append an unsigned LEB128 varint: 7 bits per byte, low bits first, high bit set on all but the last
+inline void writeVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+// Write a varint at out, which needs room for ten bytes; returns the end of what was written
+inline unsigned char* writeVarint(unsigned char* out, uint64_t value) {
+    while (value >= 0x80) {
+        *out++ = static_cast<unsigned char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    *out++ = static_cast<unsigned char>(value);
+    return out;
+}
+
+// Read a varint and advance cursor past it; returns false if it runs past end or is over-long
+inline bool readVarint(const unsigned char*& cursor, const unsigned char* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+        unsigned char byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,37 @@
+#include "CardStore.h"
+
+#include <cstring>
+
+void CardStore::shuffle(Rng& rng) {
+    // Only values move: every card is face down when a board is dealt
+    shuffleInPlace(values.data(), size(), rng);
+}
+
+void dealBoards(uint8_t* out, int boardCount, int stride, int pairs, Rng& rng) {
+    if (boardCount <= 0) {
+        return;
+    }
+    // The first board starts sorted; every later one starts as a copy of the
+    // one before, which shuffles to a uniformly random board just the same
+    for (int i = 0; i < 2 * pairs; ++i) {
+        out[i] = static_cast<uint8_t>(i / 2 + 1);
+    }
+    shuffleInPlace(out, 2 * pairs, rng);
+    for (int b = 1; b < boardCount; ++b) {
+        uint8_t* board = out + static_cast<size_t>(b) * stride;
+        std::memcpy(board, board - stride, 2 * pairs);
+        shuffleInPlace(board, 2 * pairs, rng);
+    }
+}
+
+void setupLevel(CardStore& cards, int pairs, Rng& rng) {
+    // Written in place: a store reused for the next deal never reallocates
+    int count = pairs * 2;
+    cards.values.resize(count);
+    cards.revealed.assign(count, 0);
+    cards.matched.assign(count, 0);
+    for (int i = 0; i < count; ++i) {
+        cards.values[i] = i / 2 + 1;  // Two cards per value
+    }
+    cards.shuffle(rng);
+}
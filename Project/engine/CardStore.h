@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Random.h"
+
+// Flat card storage for a board. Cards are addressed by their index in
+// board order (row-major over the level grid), and each property lives in
+// its own packed array so walks over one property touch only that array.
+class CardStore {
+public:
+    std::vector<int> values;              // Card value, 1..pairs
+    std::vector<uint8_t> revealed;        // 1 while the card is face up
+    std::vector<uint8_t> matched;         // 1 once the card's pair was found
+
+    // Number of cards on the board
+    int size() const {
+        return static_cast<int>(values.size());
+    }
+
+    // Remove all cards, keeping the allocated storage
+    void clear() {
+        values.clear();
+        revealed.clear();
+        matched.clear();
+    }
+
+    // Allocate room for the given number of cards
+    void reserve(int count) {
+        values.reserve(count);
+        revealed.reserve(count);
+        matched.reserve(count);
+    }
+
+    // Add a face-down card and return its index
+    int addCard(int value) {
+        values.push_back(value);
+        revealed.push_back(0);
+        matched.push_back(0);
+        return size() - 1;
+    }
+
+    // Shuffle the card values across the board; the same generator state
+    // gives the same order on every platform
+    void shuffle(Rng& rng);
+};
+
+// Fill the store with two cards for each value 1..pairs and shuffle it
+void setupLevel(CardStore& cards, int pairs, Rng& rng);
+
+// Deal boardCount shuffled boards of the given number of pairs (at most 255)
+// into a caller-owned buffer, board b at out + b * stride, without allocating
+void dealBoards(uint8_t* out, int boardCount, int stride, int pairs, Rng& rng);
@@ -0,0 +1,131 @@
+#include "GameState.h"
+
+#include <utility>
+
+const LevelConfig LEVELS[LEVEL_COUNT] = {
+    { 4, 4, 2 },                          // Level 1: 4 pairs, 4 columns, 2 rows
+    { 8, 4, 4 },                          // Level 2: 8 pairs, 4 columns, 4 rows
+    { 12, 6, 4 }                          // Level 3: 12 pairs, 6 columns, 4 rows
+};
+
+void startGame(GameState& game, uint64_t seed) {
+    game.seed = seed;
+    game.timeMs = 0;
+    game.gameStarted = true;
+    game.gameComplete = false;
+    startLevel(game, 0);
+}
+
+void startLevel(GameState& game, int level) {
+    startLevel(game, level, dealLevel(level, game.seed));
+}
+
+void startLevel(GameState& game, int level, CardStore&& cards) {
+    game.cards = std::move(cards);
+    game.level = level;
+    game.matchesFound = 0;
+    game.moves = 0;
+    game.levelComplete = false;
+    game.transitionElapsedMs = 0;
+    game.flippedCount = 0;
+    game.delayActive = false;
+    game.delayElapsedMs = 0;
+}
+
+CardStore dealLevel(int level, uint64_t seed) {
+    CardStore cards;
+    dealLevel(cards, level, seed);
+    return cards;
+}
+
+void dealLevel(CardStore& cards, int level, uint64_t seed) {
+    // Each level has its own stream, so it can be dealt in any order
+    Rng rng(deriveSeed(seed, static_cast<uint64_t>(level)));
+    setupLevel(cards, LEVELS[level].pairs, rng);
+}
+
+GameEvent applyFlip(GameState& game, int index) {
+    // Ignore flips outside a running board or while two cards are pending
+    if (!game.gameStarted || game.levelComplete || game.delayActive) {
+        return GameEvent::None;
+    }
+
+    if (index < 0 || index >= game.cards.size() || game.cards.revealed[index]) {
+        return GameEvent::None;
+    }
+
+    game.cards.revealed[index] = 1;
+    game.flippedCards[game.flippedCount++] = index;
+
+    if (game.flippedCount == 2) {
+        game.moves++;
+        game.delayActive = true;
+        game.delayElapsedMs = 0;
+    }
+    return GameEvent::Flipped;
+}
+
+GameEvent stepGame(GameState& game, int elapsedMs) {
+    game.timeMs += elapsedMs;
+
+    // The banner timer runs until the caller moves on with advanceLevel
+    if (game.levelComplete) {
+        if (game.transitionElapsedMs >= LEVEL_TRANSITION_MS) {
+            return GameEvent::None;
+        }
+        game.transitionElapsedMs += elapsedMs;
+        return game.transitionElapsedMs >= LEVEL_TRANSITION_MS ? GameEvent::TransitionEnded : GameEvent::None;
+    }
+
+    if (!game.delayActive) {
+        return GameEvent::None;
+    }
+
+    // Check if the delay time has passed
+    game.delayElapsedMs += elapsedMs;
+    if (game.delayElapsedMs < FLIP_BACK_DELAY_MS) {
+        return GameEvent::None;
+    }
+    return resolveFlipped(game);
+}
+
+GameEvent resolveFlipped(GameState& game) {
+    if (game.flippedCount != 2) {
+        return GameEvent::None;
+    }
+
+    int firstCard = game.flippedCards[0];
+    int secondCard = game.flippedCards[1];
+    game.flippedCount = 0;
+    game.delayActive = false;
+
+    CardStore& cards = game.cards;
+    if (cards.values[firstCard] != cards.values[secondCard]) {
+        cards.revealed[firstCard] = cards.revealed[secondCard] = 0;
+        return GameEvent::Mismatch;
+    }
+
+    cards.matched[firstCard] = cards.matched[secondCard] = 1;
+    game.matchesFound++;
+    if (game.matchesFound * 2 == cards.size()) {
+        game.levelComplete = true;
+        game.gameComplete = game.level == LEVEL_COUNT - 1;
+    }
+    return GameEvent::Match;
+}
+
+bool advanceLevel(GameState& game) {
+    if (game.level + 1 >= LEVEL_COUNT) {
+        return false;
+    }
+    startLevel(game, game.level + 1);
+    return true;
+}
+
+bool advanceLevel(GameState& game, CardStore&& nextCards) {
+    if (game.level + 1 >= LEVEL_COUNT) {
+        return false;
+    }
+    startLevel(game, game.level + 1, std::move(nextCards));
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "CardStore.h"
+
+// Board size and grid layout of a level
+struct LevelConfig {
+    int pairs;                            // Number of pairs on the board
+    int cols;                             // Grid columns
+    int rows;                             // Grid rows
+};
+
+const int LEVEL_COUNT = 3;
+extern const LevelConfig LEVELS[LEVEL_COUNT];
+
+// Delay before two flipped cards are compared and turned back
+const int FLIP_BACK_DELAY_MS = 500;
+
+// How long the level complete banner stays up before the next level starts
+const int LEVEL_TRANSITION_MS = 3000;
+
+// Length of one fixed simulation tick; the flip-back delay is a whole number of ticks
+const int SIMULATION_STEP_MS = 10;
+
+// Result of applying a flip or advancing time
+enum class GameEvent {
+    None,                                 // Nothing changed
+    Flipped,                              // A card was turned face up
+    Match,                                // The two flipped cards matched
+    Mismatch,                             // The two flipped cards were turned back down
+    TransitionEnded                       // The level complete banner has been up for LEVEL_TRANSITION_MS
+};
+
+// Complete state of one game, independent of any rendering or audio
+struct GameState {
+    CardStore cards;                      // Cards on the current board
+    uint64_t seed = 0;                    // Every board of the game is dealt from this seed
+    int64_t timeMs = 0;                   // Simulation time since the game started
+    bool gameStarted = false;
+    int level = 0;                        // Index into LEVELS
+    int matchesFound = 0;                 // Pairs found on the current board
+    int moves = 0;                        // Pairs of cards turned over on the current board
+    bool levelComplete = false;           // All pairs on the board were found
+    bool gameComplete = false;            // The last level was completed
+    int transitionElapsedMs = 0;          // Time since the level was completed
+
+    // Indices of the face-up cards waiting to be compared
+    int flippedCards[2] = { -1, -1 };
+    int flippedCount = 0;
+    bool delayActive = false;             // Two cards are waiting to be compared
+    int delayElapsedMs = 0;               // Time since the second card was flipped
+};
+
+// Start a new game on level 1; the same seed deals the same boards
+void startGame(GameState& game, uint64_t seed);
+
+// Deal the game's board for the given level index
+void startLevel(GameState& game, int level);
+
+// Start a level on a board dealt in advance by dealLevel
+void startLevel(GameState& game, int level, CardStore&& cards);
+
+// Deal the board for a level of the game with the given seed without touching
+// any game state, so the next level can be prepared on another thread while
+// the current one finishes
+CardStore dealLevel(int level, uint64_t seed);
+
+// Deal the same board into an existing store, reusing its storage
+void dealLevel(CardStore& cards, int level, uint64_t seed);
+
+// Turn over the card at the given board position
+GameEvent applyFlip(GameState& game, int index);
+
+// Advance the flip-back and level transition timers by the elapsed time
+GameEvent stepGame(GameState& game, int elapsedMs);
+
+// Compare the two flipped cards now, without waiting for the delay
+GameEvent resolveFlipped(GameState& game);
+
+// Move on to the next level after a completed one; returns false after the last level
+bool advanceLevel(GameState& game);
+
+// Move on to the next level using a board dealt in advance by dealLevel
+bool advanceLevel(GameState& game, CardStore&& nextCards);
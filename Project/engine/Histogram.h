@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "Bitboard.h"
+
+// Number of samples that had each non-negative integer value
+struct Histogram {
+    std::vector<uint64_t> counts;
+
+    void add(int value) {
+        if (value >= static_cast<int>(counts.size())) {
+            counts.resize(value + 1);
+        }
+        counts[value]++;
+    }
+
+    void merge(const Histogram& other) {
+        if (other.counts.size() > counts.size()) {
+            counts.resize(other.counts.size());
+        }
+        for (size_t i = 0; i < other.counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+    }
+
+    uint64_t total() const {
+        uint64_t sum = 0;
+        for (uint64_t count : counts) {
+            sum += count;
+        }
+        return sum;
+    }
+
+    double mean() const {
+        uint64_t samples = total();
+        double sum = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            sum += static_cast<double>(i) * counts[i];
+        }
+        return samples > 0 ? sum / samples : 0.0;
+    }
+
+    // Smallest value reached by the given fraction of samples
+    int percentile(double fraction, uint64_t total) const {
+        uint64_t target = static_cast<uint64_t>(std::ceil(fraction * total));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= std::max<uint64_t>(target, 1)) {
+                return static_cast<int>(i);
+            }
+        }
+        return static_cast<int>(counts.size()) - 1;
+    }
+};
+
+// Histogram of non-negative values over a wide range with bounded relative
+// error, after Gil Tene's HdrHistogram. Values below 2^(SUB_BITS + 1) are
+// counted exactly; above that, each power-of-two range is split into
+// 2^SUB_BITS equal buckets, so a value is known to within 1/128 of itself
+// whatever its size. Adding a value never allocates once a value as large
+// has been seen.
+struct HdrHistogram {
+    static const int SUB_BITS = 7;
+    static const uint64_t SUB_COUNT = uint64_t(1) << SUB_BITS;
+
+    std::vector<uint64_t> counts;
+    uint64_t samples = 0;
+    uint64_t maximum = 0;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < 2 * SUB_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        int shift = highestBit(value) - SUB_BITS;
+        return static_cast<size_t>((shift + 1) * SUB_COUNT + (value >> shift) - SUB_COUNT);
+    }
+
+    // Largest value counted in a bucket
+    static uint64_t highestIn(size_t bucket) {
+        if (bucket < 2 * SUB_COUNT) {
+            return bucket;
+        }
+        int shift = static_cast<int>(bucket / SUB_COUNT) - 1;
+        uint64_t lowest = (bucket % SUB_COUNT + SUB_COUNT) << shift;
+        return lowest + (uint64_t(1) << shift) - 1;
+    }
+
+    void add(uint64_t value) {
+        size_t bucket = bucketOf(value);
+        if (bucket >= counts.size()) {
+            counts.resize(bucket + 1);
+        }
+        counts[bucket]++;
+        samples++;
+        maximum = std::max(maximum, value);
+    }
+
+    void merge(const HdrHistogram& other) {
+        if (other.counts.size() > counts.size()) {
+            counts.resize(other.counts.size());
+        }
+        for (size_t i = 0; i < other.counts.size(); ++i) {
+            counts[i] += other.counts[i];
+        }
+        samples += other.samples;
+        maximum = std::max(maximum, other.maximum);
+    }
+
+    // Value the given fraction of samples are at or below, rounded up to
+    // the top of its bucket
+    uint64_t percentile(double fraction) const {
+        uint64_t target = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(fraction * samples)), 1);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts.size(); ++i) {
+            seen += counts[i];
+            if (seen >= target) {
+                return std::min(highestIn(i), maximum);
+            }
+        }
+        return maximum;
+    }
+};
@@ -0,0 +1,164 @@
+#include "ImageCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+#include "ByteOrder.h"
+#include "Hash.h"
+
+const char IMAGE_CACHE_MAGIC[4] = { 'M', 'M', 'I', 'C' };
+const uint32_t IMAGE_CACHE_VERSION = 1;
+const size_t IMAGE_CACHE_HEADER_SIZE = 24;
+
+ImageCache::ImageCache(std::string directory) : directory(std::move(directory)) {
+}
+
+std::string ImageCache::namePrefix(const std::string& name) const {
+    char prefix[32];
+    std::snprintf(prefix, sizeof(prefix), "%016llx-", static_cast<unsigned long long>(hashBytes(name.data(), name.size())));
+    return prefix;
+}
+
+const uint8_t* ImageCache::map(const std::string& name, uint64_t sourceHash, unsigned width, unsigned height, MappedFile& file) const {
+    char entry[64];
+    std::snprintf(entry, sizeof(entry), "%016llx-%ux%u.rgba", static_cast<unsigned long long>(sourceHash), width, height);
+    if (!file.open(directory + "/" + namePrefix(name) + entry)) {
+        return nullptr;
+    }
+
+    // Reject truncated or foreign files instead of handing out garbage pixels
+    const unsigned char* data = file.data();
+    size_t expected = IMAGE_CACHE_HEADER_SIZE + static_cast<size_t>(width) * height * 4;
+    if (file.size() != expected || std::memcmp(data, IMAGE_CACHE_MAGIC, 4) != 0
+        || readLittleEndian(data + 4, 4) != IMAGE_CACHE_VERSION
+        || readLittleEndian(data + 8, 4) != width || readLittleEndian(data + 12, 4) != height
+        || readLittleEndian(data + 16, 8) != sourceHash) {
+        file.close();
+        return nullptr;
+    }
+    return data + IMAGE_CACHE_HEADER_SIZE;
+}
+
+bool ImageCache::store(const std::string& name, uint64_t sourceHash, unsigned width, unsigned height, const uint8_t* pixels) const {
+    namespace fs = std::filesystem;
+    std::error_code ignored;
+    fs::create_directories(directory, ignored);
+
+    // Drop stale entries for this asset: other sources or other sizes
+    std::string prefix = namePrefix(name);
+    for (const auto& existing : fs::directory_iterator(directory, ignored)) {
+        if (existing.path().filename().string().compare(0, prefix.size(), prefix) == 0) {
+            fs::remove(existing.path(), ignored);
+        }
+    }
+
+    char entry[64];
+    std::snprintf(entry, sizeof(entry), "%016llx-%ux%u.rgba", static_cast<unsigned long long>(sourceHash), width, height);
+    std::string path = directory + "/" + prefix + entry;
+
+    std::string header(IMAGE_CACHE_MAGIC, 4);
+    writeLittleEndian(header, IMAGE_CACHE_VERSION, 4);
+    writeLittleEndian(header, width, 4);
+    writeLittleEndian(header, height, 4);
+    writeLittleEndian(header, sourceHash, 8);
+
+    // Write to a temporary name first so a reader never maps a half-written entry
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out << header;
+        out.write(reinterpret_cast<const char*>(pixels), static_cast<std::streamsize>(width) * height * 4);
+        if (!out) {
+            fs::remove(temporary, ignored);
+            return false;
+        }
+    }
+    fs::rename(temporary, path, ignored);
+    return !ignored;
+}
+
+// Source pixels contributing to one target pixel along an axis
+struct Contribution {
+    unsigned first;
+    std::vector<float> weights;
+};
+
+static std::vector<Contribution> contributions(unsigned sourceSize, unsigned targetSize) {
+    std::vector<Contribution> result(targetSize);
+    float scale = static_cast<float>(sourceSize) / targetSize;
+
+    for (unsigned i = 0; i < targetSize; ++i) {
+        Contribution& contribution = result[i];
+        float centre = (i + 0.5f) * scale;
+
+        if (scale > 1.f) {
+            // Shrinking: average every source pixel the target pixel covers
+            float start = centre - scale / 2.f;
+            float end = centre + scale / 2.f;
+            unsigned first = static_cast<unsigned>(std::max(0.f, std::floor(start)));
+            unsigned last = std::min(sourceSize - 1, static_cast<unsigned>(std::ceil(end)) - 1);
+            contribution.first = first;
+            float total = 0.f;
+            for (unsigned s = first; s <= last; ++s) {
+                float weight = std::min(end, s + 1.f) - std::max(start, static_cast<float>(s));
+                contribution.weights.push_back(std::max(0.f, weight));
+                total += contribution.weights.back();
+            }
+            for (float& weight : contribution.weights) {
+                weight /= total;
+            }
+        }
+        else {
+            // Enlarging: interpolate between the two nearest source pixels
+            float position = std::min(static_cast<float>(sourceSize - 1), std::max(0.f, centre - 0.5f));
+            unsigned first = static_cast<unsigned>(position);
+            float fraction = position - first;
+            contribution.first = first;
+            contribution.weights.push_back(1.f - fraction);
+            if (first + 1 < sourceSize) {
+                contribution.weights.push_back(fraction);
+            }
+        }
+    }
+    return result;
+}
+
+void resizeImage(const uint8_t* source, unsigned sourceWidth, unsigned sourceHeight, uint8_t* target, unsigned targetWidth, unsigned targetHeight) {
+    std::vector<Contribution> columns = contributions(sourceWidth, targetWidth);
+    std::vector<Contribution> rows = contributions(sourceHeight, targetHeight);
+
+    // Horizontal pass into a float buffer, then vertical pass into the target
+    std::vector<float> horizontal(static_cast<size_t>(targetWidth) * sourceHeight * 4);
+    for (unsigned y = 0; y < sourceHeight; ++y) {
+        const uint8_t* sourceRow = source + static_cast<size_t>(y) * sourceWidth * 4;
+        float* row = &horizontal[static_cast<size_t>(y) * targetWidth * 4];
+        for (unsigned x = 0; x < targetWidth; ++x) {
+            const Contribution& contribution = columns[x];
+            float sum[4] = { 0.f, 0.f, 0.f, 0.f };
+            for (size_t k = 0; k < contribution.weights.size(); ++k) {
+                const uint8_t* pixel = sourceRow + (contribution.first + k) * 4;
+                for (int channel = 0; channel < 4; ++channel) {
+                    sum[channel] += pixel[channel] * contribution.weights[k];
+                }
+            }
+            std::memcpy(row + x * 4, sum, sizeof(sum));
+        }
+    }
+
+    for (unsigned y = 0; y < targetHeight; ++y) {
+        const Contribution& contribution = rows[y];
+        uint8_t* targetRow = target + static_cast<size_t>(y) * targetWidth * 4;
+        for (unsigned x = 0; x < targetWidth * 4; ++x) {
+            float sum = 0.f;
+            for (size_t k = 0; k < contribution.weights.size(); ++k) {
+                sum += horizontal[(contribution.first + k) * targetWidth * 4 + x] * contribution.weights[k];
+            }
+            targetRow[x] = static_cast<uint8_t>(std::min(255.f, std::max(0.f, sum + 0.5f)));
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+// On-disk cache of decoded images already resized for the display. Each
+// entry holds raw RGBA pixels keyed by the asset name, a hash of the source
+// file and the target size, so loading one is a plain memory copy instead
+// of a PNG/JPEG decode. An entry whose source hash no longer matches is
+// never found and gets replaced the next time the image is stored.
+//
+// Entry file: "MMIC", uint32 version, uint32 width, uint32 height,
+// uint64 source hash (all little-endian), then width * height * 4 bytes.
+class ImageCache {
+public:
+    explicit ImageCache(std::string directory);
+
+    // Map the cached pixels for a source and size; returns a pointer into
+    // file, or nullptr when no matching entry exists
+    const uint8_t* map(const std::string& name, uint64_t sourceHash, unsigned width, unsigned height, MappedFile& file) const;
+
+    // Write the pixels for a source and size, removing older entries for the same name
+    bool store(const std::string& name, uint64_t sourceHash, unsigned width, unsigned height, const uint8_t* pixels) const;
+
+private:
+    // File name prefix shared by every entry of one asset name
+    std::string namePrefix(const std::string& name) const;
+
+    std::string directory;
+};
+
+// Resample RGBA pixels to a new size: box filtering when shrinking an axis,
+// linear interpolation when enlarging it
+void resizeImage(const uint8_t* source, unsigned sourceWidth, unsigned sourceHeight, uint8_t* target, unsigned targetWidth, unsigned targetHeight);
@@ -0,0 +1,43 @@
+#include "Layout.h"
+
+#include <algorithm>
+
+int GridLayout::cardAt(float x, float y, int cardCount) const {
+    float pitch = cardSize + spacing;
+    if (pitch <= 0.f) {
+        return -1;
+    }
+
+    float localX = x - offsetX;
+    float localY = y - offsetY;
+    if (localX < 0.f || localY < 0.f) {
+        return -1;
+    }
+
+    int col = static_cast<int>(localX / pitch);
+    int row = static_cast<int>(localY / pitch);
+    if (col >= cols || row >= rows) {
+        return -1;
+    }
+
+    // Points in the spacing between cards do not hit anything
+    if (localX - col * pitch > cardSize || localY - row * pitch > cardSize) {
+        return -1;
+    }
+
+    int index = row * cols + col;
+    return index < cardCount ? index : -1;
+}
+
+GridLayout computeGridLayout(float windowWidth, float windowHeight, int cols, int rows, float spacing) {
+    GridLayout layout;
+    layout.cols = cols;
+    layout.rows = rows;
+    layout.spacing = spacing;
+    layout.cardSize = std::min((windowWidth - (cols + 1) * spacing) / cols, (windowHeight - (rows + 1) * spacing) / rows) * 0.75f; // Scale down the card size
+
+    // Calculate the offsets to center the grid
+    layout.offsetX = (windowWidth - (cols * layout.cardSize + (cols - 1) * spacing)) / 2.f;
+    layout.offsetY = (windowHeight - (rows * layout.cardSize + (rows - 1) * spacing)) / 2.f;
+    return layout;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+// Regular cols x rows grid of square cards centred in a window. Maps board
+// indices to screen positions and screen positions back to board indices.
+struct GridLayout {
+    int cols = 1;
+    int rows = 1;
+    float cardSize = 0.f;                 // Width and height of every card
+    float spacing = 0.f;                  // Gap between neighbouring cards
+    float offsetX = 0.f;                  // Left edge of the first column
+    float offsetY = 0.f;                  // Top edge of the first row
+
+    // Left edge of the card at the given board index
+    float cardX(int index) const {
+        return offsetX + (index % cols) * (cardSize + spacing);
+    }
+
+    // Top edge of the card at the given board index
+    float cardY(int index) const {
+        return offsetY + (index / cols) * (cardSize + spacing);
+    }
+
+    // Board index of the card under a point, or -1 for gaps and points off the grid
+    int cardAt(float x, float y, int cardCount) const;
+};
+
+// Fit a cols x rows grid into a window, matching the game's card sizing
+GridLayout computeGridLayout(float windowWidth, float windowHeight, int cols, int rows, float spacing);
@@ -0,0 +1,125 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    length = static_cast<size_t>(fileSize.QuadPart);
+    mapped = true;
+    if (length == 0) {
+        return true;
+    }
+
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        close();
+        return false;
+    }
+
+    bytes = static_cast<const unsigned char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (bytes == nullptr) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) {
+        UnmapViewOfFile(bytes);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+    bytes = nullptr;
+    mappingHandle = fileHandle = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+void MappedFile::prefetch() const {
+    // FILE_FLAG_SEQUENTIAL_SCAN already asks the cache manager to read ahead
+}
+
+#else
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    length = static_cast<size_t>(info.st_size);
+    mapped = true;
+    if (length > 0) {
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) {
+            ::close(fd);
+            length = 0;
+            mapped = false;
+            return false;
+        }
+        bytes = static_cast<const unsigned char*>(address);
+    }
+
+    // The mapping keeps the file alive on its own
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (bytes != nullptr) {
+        munmap(const_cast<unsigned char*>(bytes), length);
+    }
+    bytes = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+void MappedFile::prefetch() const {
+    if (bytes != nullptr) {
+        madvise(const_cast<unsigned char*>(bytes), length, MADV_SEQUENTIAL);
+        madvise(const_cast<unsigned char*>(bytes), length, MADV_WILLNEED);
+    }
+}
+
+#endif
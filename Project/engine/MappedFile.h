@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The mapped bytes stay valid
+// until the object is closed or destroyed, so decoders can read straight
+// from them without copying the file into a buffer first.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Map the file; returns false when it cannot be opened or mapped
+    bool open(const std::string& path);
+
+    // Unmap the file
+    void close();
+
+    // Ask the OS to read the whole mapping ahead in one sequential pass
+    void prefetch() const;
+
+    bool isOpen() const {
+        return mapped;
+    }
+
+    const unsigned char* data() const {
+        return bytes;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+    bool mapped = false;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+};
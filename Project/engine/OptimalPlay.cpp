@@ -0,0 +1,163 @@
+#include "OptimalPlay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include "ByteOrder.h"
+#include "MappedFile.h"
+
+const char OPTIMAL_TABLE_MAGIC[4] = { 'M', 'M', 'O', 'P' };
+const uint32_t OPTIMAL_TABLE_VERSION = 1;
+const size_t OPTIMAL_TABLE_HEADER_SIZE = 12;
+const size_t OPTIMAL_TABLE_CELL_SIZE = 9;
+
+void OptimalTable::solveCell(int n, int k) {
+    if (n == 0) {
+        expectations[cell(0, 0)] = 0.0;
+        choices[cell(0, 0)] = 0;
+        return;
+    }
+
+    double unseen = 2.0 * n - k;
+    // The first card completes a known singleton: take the pair
+    double result = 1.0;
+    if (k > 0) {
+        result += k / unseen * expected(n - 1, k - 1);
+    }
+
+    // The first card is new: its partner and 2(n - k - 1) other new cards remain unseen
+    bool knownSecond = false;
+    if (k < n) {
+        double rest = unseen - 1.0;
+        double secondUnseen = 1.0 / rest * expected(n - 1, k)
+                            + k / rest * (1.0 + expected(n - 1, k));
+        if (n - k - 1 > 0) {
+            secondUnseen += (rest - 1.0 - k) / rest * expected(n, k + 2);
+        }
+        double best = secondUnseen;
+        // Turning over a known card instead keeps the other new cards hidden
+        if (k > 0 && expected(n, k + 1) < secondUnseen) {
+            best = expected(n, k + 1);
+            knownSecond = true;
+        }
+        result += (unseen - k) / unseen * best;
+    }
+
+    expectations[cell(n, k)] = result;
+    choices[cell(n, k)] = knownSecond ? 1 : 0;
+}
+
+bool OptimalTable::solve(int maxPairs, unsigned threadCount) {
+    // The table's length is worked out from maxPairs, so check it first
+    if (maxPairs < 0 || maxPairs > OPTIMAL_TABLE_MAX_PAIRS) {
+        return false;
+    }
+    pairs = maxPairs;
+    expectations.assign(cell(maxPairs + 1, 0), 0.0);
+    choices.assign(cell(maxPairs + 1, 0), 0);
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Row n is solved from k = n down to 0. Cell (n, k) needs (n, k + 1) and
+    // (n, k + 2) from its own row and (n - 1, k), (n - 1, k - 1) from the row
+    // before, so rows run as a pipeline: each thread takes every
+    // threadCount-th row and follows one cell behind the row above it.
+    // lowestDone[n] is the smallest k solved so far in row n.
+    std::unique_ptr<std::atomic<int>[]> lowestDone(new std::atomic<int>[maxPairs + 1]);
+    for (int n = 0; n <= maxPairs; ++n) {
+        lowestDone[n].store(n + 1, std::memory_order_relaxed);
+    }
+
+    auto solveRows = [&](unsigned first) {
+        for (int n = static_cast<int>(first); n <= maxPairs; n += static_cast<int>(threadCount)) {
+            for (int k = n; k >= 0; --k) {
+                if (n > 0) {
+                    int needed = std::max(k - 1, 0);
+                    while (lowestDone[n - 1].load(std::memory_order_acquire) > needed) {
+                        std::this_thread::yield();
+                    }
+                }
+                solveCell(n, k);
+                lowestDone[n].store(k, std::memory_order_release);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threadCount; ++t) {
+        workers.emplace_back(solveRows, t);
+    }
+    solveRows(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return true;
+}
+
+double OptimalTable::expectedMoves(int unseenCards, int singletons, int knownPairs) const {
+    // Unseen cards are the singletons' partners plus both cards of every untouched pair
+    int unmatchedPairs = singletons + (unseenCards - singletons) / 2;
+    return knownPairs + expected(unmatchedPairs, singletons);
+}
+
+bool OptimalTable::save(const std::string& path, std::string& error) const {
+    std::string out(OPTIMAL_TABLE_MAGIC, 4);
+    writeLittleEndian(out, OPTIMAL_TABLE_VERSION, 4);
+    writeLittleEndian(out, static_cast<uint32_t>(pairs), 4);
+    out.reserve(OPTIMAL_TABLE_HEADER_SIZE + expectations.size() * OPTIMAL_TABLE_CELL_SIZE);
+    for (size_t i = 0; i < expectations.size(); ++i) {
+        uint64_t bits;
+        std::memcpy(&bits, &expectations[i], sizeof(bits));
+        writeLittleEndian(out, bits, 8);
+        out.push_back(static_cast<char>(choices[i]));
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << out;
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+bool OptimalTable::load(const std::string& path, std::string& error) {
+    MappedFile file;
+    if (!file.open(path)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    const unsigned char* data = file.data();
+    if (file.size() < OPTIMAL_TABLE_HEADER_SIZE || std::memcmp(data, OPTIMAL_TABLE_MAGIC, 4) != 0
+        || readLittleEndian(data + 4, 4) != OPTIMAL_TABLE_VERSION) {
+        error = path + " is not an optimal play table";
+        return false;
+    }
+    // Check the size before it is used to work out the table's length
+    uint64_t storedPairs = readLittleEndian(data + 8, 4);
+    if (storedPairs > static_cast<uint64_t>(OPTIMAL_TABLE_MAX_PAIRS)) {
+        error = path + " holds boards of " + std::to_string(storedPairs) + " pairs, more than " + std::to_string(OPTIMAL_TABLE_MAX_PAIRS);
+        return false;
+    }
+    int maxPairs = static_cast<int>(storedPairs);
+    size_t cells = cell(maxPairs + 1, 0);
+    if (file.size() != OPTIMAL_TABLE_HEADER_SIZE + cells * OPTIMAL_TABLE_CELL_SIZE) {
+        error = path + " is truncated";
+        return false;
+    }
+
+    pairs = maxPairs;
+    expectations.resize(cells);
+    choices.resize(cells);
+    const unsigned char* cursor = data + OPTIMAL_TABLE_HEADER_SIZE;
+    for (size_t i = 0; i < cells; ++i, cursor += OPTIMAL_TABLE_CELL_SIZE) {
+        uint64_t bits = readLittleEndian(cursor, 8);
+        std::memcpy(&expectations[i], &bits, sizeof(bits));
+        choices[i] = cursor[8];
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Largest board a table is solved or loaded for; its table is about 1.2 GB
+const int OPTIMAL_TABLE_MAX_PAIRS = 16384;
+
+// Exact expected number of moves to clear a board under optimal play, by
+// dynamic programming over abstract board states. A state is the number of
+// unseen cards, the known singletons (one card seen, its partner unseen)
+// and the known pairs (both cards seen, not yet taken). Known pairs are
+// always taken at one move each, so the table is over
+//
+//   E(n, k): n unmatched pairs of which k are known singletons,
+//
+// with 2n - k unseen cards. Each move turns over an unseen card; if it is
+// the partner of a known singleton the pair is taken, otherwise the player
+// either turns over a second unseen card or deliberately turns over a known
+// card to learn nothing more, whichever is better.
+//
+// Table file (little-endian): "MMOP", uint32 version, uint32 max pairs, then
+// for every n = 0..max and k = 0..n a float64 E(n, k) and a uint8 that is 1
+// when the best second card is a known one.
+class OptimalTable {
+public:
+    // Solve every board of up to maxPairs pairs; false, leaving the table as
+    // it was, unless maxPairs is 0..OPTIMAL_TABLE_MAX_PAIRS. 0 threads uses
+    // one per hardware thread
+    bool solve(int maxPairs, unsigned threadCount = 0);
+
+    // Largest board in the table, or -1 when empty
+    int maxPairs() const {
+        return pairs;
+    }
+
+    // E(n, k) for n unmatched pairs with k known singletons
+    double expected(int unmatchedPairs, int singletons) const {
+        return expectations[cell(unmatchedPairs, singletons)];
+    }
+
+    // Whether optimal play turns over a known card second after a new first card
+    bool flipsKnownSecond(int unmatchedPairs, int singletons) const {
+        return choices[cell(unmatchedPairs, singletons)] != 0;
+    }
+
+    // Expected moves left from a position described by its card counts
+    double expectedMoves(int unseenCards, int singletons, int knownPairs) const;
+
+    // Expected moves for a fresh board
+    double expectedMoves(int boardPairs) const {
+        return expected(boardPairs, 0);
+    }
+
+    bool save(const std::string& path, std::string& error) const;
+    bool load(const std::string& path, std::string& error);
+
+private:
+    // Index of E(n, k) in the triangular table
+    static size_t cell(int n, int k) {
+        return static_cast<size_t>(n) * (n + 1) / 2 + k;
+    }
+
+    // Solve one cell whose dependencies are done
+    void solveCell(int n, int k);
+
+    int pairs = -1;
+    std::vector<double> expectations;
+    std::vector<uint8_t> choices;
+};
@@ -0,0 +1,149 @@
+#include "Protocol.h"
+
+#include <cstring>
+#include "ByteOrder.h"
+
+// Number of fields in the body of each message type, or -1 for an unknown type
+static int fieldCount(MessageType type) {
+    switch (type) {
+    case MessageType::StartGame: return 0;
+    case MessageType::Flip: return 1;
+    case MessageType::LevelStarted: return 4;
+    case MessageType::Revealed: return 2;
+    case MessageType::Match: return 2;
+    case MessageType::Mismatch: return 2;
+    case MessageType::Rejected: return 1;
+    case MessageType::GameComplete: return 1;
+    }
+    return -1;
+}
+
+unsigned char* MessageBuffer::space(size_t minimum) {
+    if (capacity - end < minimum && begin > 0) {
+        std::memmove(bytes.get(), bytes.get() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+    }
+    return bytes.get() + end;
+}
+
+void MessageBuffer::consume(size_t count) {
+    begin += count;
+    if (begin == end) {
+        begin = end = 0;
+    }
+}
+
+size_t encodeMessage(unsigned char* out, const Message& message) {
+    int fields[4] = {};
+    switch (message.type) {
+    case MessageType::StartGame:
+        break;
+    case MessageType::Flip:
+    case MessageType::Rejected:
+        fields[0] = message.card;
+        break;
+    case MessageType::LevelStarted:
+        fields[0] = message.level;
+        fields[1] = message.config.pairs;
+        fields[2] = message.config.cols;
+        fields[3] = message.config.rows;
+        break;
+    case MessageType::Revealed:
+        fields[0] = message.card;
+        fields[1] = message.value;
+        break;
+    case MessageType::Match:
+    case MessageType::Mismatch:
+        fields[0] = message.card;
+        fields[1] = message.other;
+        break;
+    case MessageType::GameComplete:
+        fields[0] = message.moves;
+        break;
+    }
+
+    // A field out of range would reach the peer as some other valid value
+    int count = fieldCount(message.type);
+    for (int i = 0; i < count; ++i) {
+        if (fields[i] < 0 || fields[i] > MESSAGE_FIELD_MAX) {
+            return 0;
+        }
+    }
+    unsigned char* cursor = out + 2;
+    for (int i = 0; i < count; ++i) {
+        cursor = writeVarint(cursor, static_cast<uint64_t>(fields[i]));
+    }
+    out[0] = static_cast<unsigned char>(message.type);
+    out[1] = static_cast<unsigned char>(cursor - out - 2);
+    return static_cast<size_t>(cursor - out);
+}
+
+bool encodeMessage(MessageBuffer& out, const Message& message) {
+    unsigned char* space = out.space(MESSAGE_MAX_SIZE);
+    if (out.spaceLeft() < MESSAGE_MAX_SIZE) {
+        out.overflowed = true;
+        return false;
+    }
+    size_t size = encodeMessage(space, message);
+    out.commit(size);
+    return size != 0;
+}
+
+DecodeResult decodeMessage(const unsigned char* data, size_t size, Message& message, size_t& used) {
+    if (size < 2) {
+        return DecodeResult::Incomplete;
+    }
+    MessageType type = static_cast<MessageType>(data[0]);
+    int count = fieldCount(type);
+    if (count < 0 || data[1] < count || data[1] > 3 * count) {
+        return DecodeResult::Malformed;
+    }
+    if (size < 2 + static_cast<size_t>(data[1])) {
+        return DecodeResult::Incomplete;
+    }
+
+    // Every field must fit the body, and the body hold nothing else
+    int fields[4] = {};
+    const unsigned char* cursor = data + 2;
+    const unsigned char* end = cursor + data[1];
+    for (int i = 0; i < count; ++i) {
+        uint64_t field;
+        if (!readVarint(cursor, end, field) || field > static_cast<uint64_t>(MESSAGE_FIELD_MAX)) {
+            return DecodeResult::Malformed;
+        }
+        fields[i] = static_cast<int>(field);
+    }
+    if (cursor != end) {
+        return DecodeResult::Malformed;
+    }
+
+    message = Message();
+    message.type = type;
+    switch (type) {
+    case MessageType::StartGame:
+        break;
+    case MessageType::Flip:
+    case MessageType::Rejected:
+        message.card = fields[0];
+        break;
+    case MessageType::LevelStarted:
+        message.level = fields[0];
+        message.config = { fields[1], fields[2], fields[3] };
+        break;
+    case MessageType::Revealed:
+        message.card = fields[0];
+        message.value = fields[1];
+        break;
+    case MessageType::Match:
+    case MessageType::Mismatch:
+        message.card = fields[0];
+        message.other = fields[1];
+        break;
+    case MessageType::GameComplete:
+        message.moves = fields[0];
+        break;
+    }
+    used = 2 + static_cast<size_t>(data[1]);
+    return DecodeResult::Complete;
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "GameState.h"
+
+// Messages between a game server and its players. The server deals the
+// boards and keeps every card value to itself; a player asks to flip
+// cards and learns a value only when the server turns that card up.
+//
+// Frame: uint8 type, uint8 body length, then the body's fields, each an
+// unsigned varint (see ByteOrder.h), so a flip of any card on the boards
+// there are takes three bytes:
+//   StartGame     (nothing)
+//   Flip          card
+//   LevelStarted  level, pairs, cols, rows
+//   Revealed      card, value
+//   Match         first card, second card
+//   Mismatch      first card, second card
+//   Rejected      card
+//   GameComplete  moves over all levels
+
+enum class MessageType : uint8_t {
+    // Player to server
+    StartGame = 1,                        // Start a new game, ending any game in progress
+    Flip = 2,                             // Turn a card over
+
+    // Server to player
+    LevelStarted = 16,                    // A new board is dealt face down
+    Revealed = 17,                        // A flip was accepted and shows this value
+    Match = 18,                           // The two face-up cards matched and stay up
+    Mismatch = 19,                        // The two face-up cards were turned back down
+    Rejected = 20,                        // A flip was not allowed: no game, a pending pair or a face-up card
+    GameComplete = 21                     // The last level was completed
+};
+
+// One decoded message; only the fields of its type are set
+struct Message {
+    MessageType type = MessageType::StartGame;
+    int level = 0;                        // LevelStarted
+    LevelConfig config = {};              // LevelStarted
+    int card = -1;                        // Flip, Revealed, Rejected; first card of Match and Mismatch
+    int other = -1;                       // Second card of Match and Mismatch
+    int value = 0;                        // Revealed
+    int moves = 0;                        // GameComplete
+};
+
+// Largest field value and largest encoded message in bytes: four fields of up to three bytes
+const int MESSAGE_FIELD_MAX = 0xFFFF;
+const size_t MESSAGE_MAX_SIZE = 2 + 4 * 3;
+
+// Bytes a connection has received but not decoded, or encoded but not
+// sent, in a block allocated once. Bytes are added at the end, straight
+// from the socket or the encoder, and consumed from the front; whatever
+// is left is moved back to the start when the free space runs short.
+class MessageBuffer {
+public:
+    explicit MessageBuffer(size_t capacity = 4096) : bytes(new unsigned char[capacity]), capacity(capacity) {
+    }
+
+    const unsigned char* data() const {
+        return bytes.get() + begin;
+    }
+
+    size_t size() const {
+        return end - begin;
+    }
+
+    bool empty() const {
+        return begin == end;
+    }
+
+    // Free space after the data, at least minimum bytes of it if the
+    // buffer has that much room at all; commit() what was written there
+    unsigned char* space(size_t minimum = 1);
+
+    size_t spaceLeft() const {
+        return capacity - end;
+    }
+
+    void commit(size_t count) {
+        end += count;
+    }
+
+    void consume(size_t count);
+
+    void clear() {
+        begin = end = 0;
+        overflowed = false;
+    }
+
+    // Set when an encode found no room, which the owner should treat as a
+    // peer that stopped reading
+    bool overflowed = false;
+
+private:
+    std::unique_ptr<unsigned char[]> bytes;
+    size_t capacity;
+    size_t begin = 0;
+    size_t end = 0;
+};
+
+enum class DecodeResult {
+    Complete,                             // A message was decoded
+    Incomplete,                           // More bytes are needed
+    Malformed                             // The bytes are not a valid message
+};
+
+// Encode a message at out, which needs MESSAGE_MAX_SIZE bytes free; returns
+// the bytes written, or 0 if a field is outside 0..MESSAGE_FIELD_MAX
+size_t encodeMessage(unsigned char* out, const Message& message);
+
+// Append a message to out; returns false if it wrote nothing, because a
+// field is out of range or out has no room, which also sets out.overflowed
+bool encodeMessage(MessageBuffer& out, const Message& message);
+
+// Decode the message at the start of data; on Complete, used is set to its size
+DecodeResult decodeMessage(const unsigned char* data, size_t size, Message& message, size_t& used);
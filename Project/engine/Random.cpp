@@ -0,0 +1,32 @@
+#include "Random.h"
+
+#include <chrono>
+#include <random>
+
+// One step of splitmix64
+static uint64_t splitMix(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+Rng::Rng(uint64_t seed) {
+    for (uint64_t& word : state) {
+        word = splitMix(seed);
+    }
+}
+
+uint64_t deriveSeed(uint64_t seed, uint64_t stream) {
+    uint64_t state = seed ^ (stream * 0xD1B54A32D192ED03ull);
+    splitMix(state);
+    return splitMix(state);
+}
+
+uint64_t randomSeed() {
+    // random_device alone may be deterministic on some platforms, so mix in the clock
+    std::random_device device;
+    uint64_t entropy = (static_cast<uint64_t>(device()) << 32) ^ device();
+    uint64_t state = entropy ^ static_cast<uint64_t>(std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    return splitMix(state);
+}
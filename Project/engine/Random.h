@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+// xoshiro256** generator. Unlike the standard library engines and
+// distributions, its output and every helper below are fully specified, so
+// a seed deals the same board with every compiler and on every platform.
+class Rng {
+public:
+    using result_type = uint64_t;
+
+    // Expand a 64-bit seed into the generator state with splitmix64
+    explicit Rng(uint64_t seed = 0);
+
+    uint64_t next() {
+        uint64_t result = rotateLeft(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotateLeft(state[3], 45);
+        return result;
+    }
+
+    // Uniform integer in [0, bound), bound > 0
+    uint32_t below(uint32_t bound);
+
+    // Standard UniformRandomBitGenerator interface
+    uint64_t operator()() {
+        return next();
+    }
+    static constexpr uint64_t min() {
+        return 0;
+    }
+    static constexpr uint64_t max() {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+private:
+    static uint64_t rotateLeft(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    uint64_t state[4];
+};
+
+// Seed derived from a parent seed and a stream number, for independent
+// generators per level or per thread that all follow from one recorded seed
+uint64_t deriveSeed(uint64_t seed, uint64_t stream);
+
+// Fresh unpredictable seed for a game nobody asked to reproduce
+uint64_t randomSeed();
+
+// Uniform integer in [0, bound), bound > 0, from 32-bit draws by Lemire's
+// multiply-shift method; a draw is only repeated in the rare rejected case
+template <typename Draw>
+inline uint32_t boundedDraw(Draw& draw, uint32_t bound) {
+    uint64_t product = static_cast<uint64_t>(draw()) * bound;
+    uint32_t low = static_cast<uint32_t>(product);
+    if (low < bound) {
+        uint32_t threshold = static_cast<uint32_t>(-bound) % bound;
+        while (low < threshold) {
+            product = static_cast<uint64_t>(draw()) * bound;
+            low = static_cast<uint32_t>(product);
+        }
+    }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+inline uint32_t Rng::below(uint32_t bound) {
+    auto draw = [this]() { return static_cast<uint32_t>(next() >> 32); };
+    return boundedDraw(draw, bound);
+}
+
+// Shuffle values[0, count) in place with Fisher-Yates. Each 64-bit output
+// of the generator serves two swaps, one per 32-bit half.
+template <typename T>
+void shuffleInPlace(T* values, int count, Rng& rng) {
+    uint64_t bits = 0;
+    bool lowHalfLeft = false;
+    auto draw = [&]() {
+        if (lowHalfLeft) {
+            lowHalfLeft = false;
+            return static_cast<uint32_t>(bits);
+        }
+        bits = rng.next();
+        lowHalfLeft = true;
+        return static_cast<uint32_t>(bits >> 32);
+    };
+
+    for (int i = count - 1; i > 0; --i) {
+        int j = static_cast<int>(boundedDraw(draw, static_cast<uint32_t>(i + 1)));
+        T swapped = values[i];
+        values[i] = values[j];
+        values[j] = swapped;
+    }
+}
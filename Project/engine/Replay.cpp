@@ -0,0 +1,306 @@
+#include "Replay.h"
+
+#include <algorithm>
+#include <cstring>
+#include "ByteOrder.h"
+
+const char REPLAY_MAGIC[4] = { 'M', 'M', 'R', 'P' };
+const uint32_t REPLAY_VERSION = 1;
+const size_t REPLAY_BLOCK_SIZE = 64 * 1024;
+
+ReplayWriter::~ReplayWriter() {
+    if (isOpen()) {
+        close(lastTimeMs);
+    }
+}
+
+bool ReplayWriter::open(const std::string& path, uint64_t seed) {
+    // A new game's recording finishes the previous one
+    if (isOpen()) {
+        close(lastTimeMs);
+    }
+    out.open(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return false;
+    }
+    buffer.clear();
+    buffer.reserve(REPLAY_BLOCK_SIZE * 2);
+    buffer.append(REPLAY_MAGIC, 4);
+    writeLittleEndian(buffer, REPLAY_VERSION, 4);
+    writeVarint(buffer, seed);
+    lastTimeMs = 0;
+    return true;
+}
+
+void ReplayWriter::beginEvent(ReplayEventType type, int64_t timeMs) {
+    buffer.push_back(static_cast<char>(type));
+    // Time never runs backwards within a game; clamp rather than write a huge delta
+    writeVarint(buffer, static_cast<uint64_t>(timeMs > lastTimeMs ? timeMs - lastTimeMs : 0));
+    lastTimeMs = std::max(lastTimeMs, timeMs);
+}
+
+void ReplayWriter::flushIfFull() {
+    if (buffer.size() >= REPLAY_BLOCK_SIZE) {
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        buffer.clear();
+    }
+}
+
+void ReplayWriter::levelStart(int64_t timeMs, int level, const LevelConfig& config) {
+    if (!isOpen()) {
+        return;
+    }
+    beginEvent(ReplayEventType::LevelStart, timeMs);
+    writeVarint(buffer, static_cast<uint64_t>(level));
+    writeVarint(buffer, static_cast<uint64_t>(config.pairs));
+    writeVarint(buffer, static_cast<uint64_t>(config.cols));
+    writeVarint(buffer, static_cast<uint64_t>(config.rows));
+    flushIfFull();
+}
+
+void ReplayWriter::flip(int64_t timeMs, int card) {
+    if (!isOpen()) {
+        return;
+    }
+    beginEvent(ReplayEventType::Flip, timeMs);
+    writeVarint(buffer, static_cast<uint64_t>(card));
+    flushIfFull();
+}
+
+bool ReplayWriter::close(int64_t timeMs) {
+    if (!isOpen()) {
+        return false;
+    }
+    beginEvent(ReplayEventType::End, timeMs);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    buffer.clear();
+    bool written = static_cast<bool>(out);
+    out.close();
+    return written;
+}
+
+bool ReplayReader::open(const std::string& path, std::string& error) {
+    if (!file.open(path)) {
+        error = "cannot read " + path;
+        return false;
+    }
+    return openMemory(file.data(), file.size(), error);
+}
+
+bool ReplayReader::openMemory(const unsigned char* data, size_t size, std::string& error) {
+    begin = cursor = end = nullptr;
+    if (size < 8 || std::memcmp(data, REPLAY_MAGIC, 4) != 0 || readLittleEndian(data + 4, 4) != REPLAY_VERSION) {
+        error = "not a replay";
+        return false;
+    }
+    const unsigned char* position = data + 8;
+    if (!readVarint(position, data + size, gameSeed)) {
+        error = "truncated header";
+        return false;
+    }
+    begin = position;
+    end = data + size;
+    bytes = size;
+    rewind();
+    return true;
+}
+
+void ReplayReader::rewind() {
+    cursor = begin;
+    timeMs = 0;
+    ended = false;
+    failure.clear();
+}
+
+ReplayPosition ReplayReader::position() const {
+    ReplayPosition position;
+    position.offset = static_cast<size_t>(cursor - begin);
+    position.timeMs = timeMs;
+    return position;
+}
+
+void ReplayReader::seek(const ReplayPosition& position) {
+    cursor = begin + position.offset;
+    timeMs = position.timeMs;
+    ended = false;
+    failure.clear();
+}
+
+bool ReplayReader::next(ReplayEvent& event) {
+    if (ended || cursor == nullptr) {
+        return false;
+    }
+    if (cursor == end) {
+        // A recording cut short by a crash has no End event; what is there is still valid
+        ended = true;
+        return false;
+    }
+
+    event = ReplayEvent();
+    event.type = static_cast<ReplayEventType>(*cursor++);
+    uint64_t delta;
+    if (!readVarint(cursor, end, delta)) {
+        failure = "truncated event";
+        ended = true;
+        return false;
+    }
+    timeMs += static_cast<int64_t>(delta);
+    event.timeMs = timeMs;
+
+    uint64_t fields[4];
+    switch (event.type) {
+    case ReplayEventType::LevelStart:
+        for (uint64_t& field : fields) {
+            if (!readVarint(cursor, end, field) || field > 0xFFFF) {
+                failure = "malformed level start";
+                ended = true;
+                return false;
+            }
+        }
+        event.level = static_cast<int>(fields[0]);
+        event.config = { static_cast<int>(fields[1]), static_cast<int>(fields[2]), static_cast<int>(fields[3]) };
+        return true;
+    case ReplayEventType::Flip:
+        if (!readVarint(cursor, end, fields[0]) || fields[0] > 0xFFFF) {
+            failure = "malformed flip";
+            ended = true;
+            return false;
+        }
+        event.card = static_cast<int>(fields[0]);
+        return true;
+    case ReplayEventType::End:
+        ended = true;
+        return true;
+    }
+    failure = "unknown event type";
+    ended = true;
+    return false;
+}
+
+ReplayDriver::ReplayDriver(ReplayReader& reader) : reader(reader) {
+}
+
+void ReplayDriver::start(GameState& game) {
+    reader.rewind();
+    hasPending = false;
+    done = false;
+    flips = 0;
+    failure.clear();
+    startGame(game, reader.seed());
+}
+
+void ReplayDriver::resume(const ReplayPosition& position, int flips) {
+    reader.seek(position);
+    hasPending = false;
+    done = false;
+    this->flips = flips;
+    failure.clear();
+}
+
+bool ReplayDriver::apply(GameState& game, const ReplayEvent& event) {
+    if (event.type == ReplayEventType::LevelStart) {
+        // Levels advance by the game's own rules; the record only confirms them
+        const LevelConfig& config = LEVELS[game.level];
+        if (event.level != game.level || event.config.pairs != config.pairs || event.config.cols != config.cols || event.config.rows != config.rows) {
+            failure = "level " + std::to_string(event.level + 1) + " was recorded with a different layout";
+            done = true;
+            return false;
+        }
+        return true;
+    }
+
+    if (applyFlip(game, event.card) != GameEvent::Flipped) {
+        failure = "flip of card " + std::to_string(event.card) + " at " + std::to_string(event.timeMs) + " ms was not allowed";
+        done = true;
+        return false;
+    }
+    return true;
+}
+
+bool replayHeadless(ReplayReader& reader, GameState& game, std::string& error) {
+    ReplayDriver driver(reader);
+    driver.start(game);
+
+    for (;;) {
+        if (!driver.applyDue(game)) {
+            error = driver.error();
+            return false;
+        }
+        // Once the recording ends, run on only until the last comparison is made
+        if (driver.finished() && !game.delayActive && (!game.levelComplete || game.gameComplete)) {
+            return true;
+        }
+
+        GameEvent event = stepGame(game, SIMULATION_STEP_MS);
+        if (event == GameEvent::TransitionEnded && !advanceLevel(game)) {
+            return true;
+        }
+    }
+}
+
+bool ReplayIndex::build(ReplayReader& reader, int interval, std::string& error) {
+    keyframes.clear();
+    flipTimes.clear();
+    ReplayDriver driver(reader);
+    GameState game;
+    driver.start(game);
+    keyframes.push_back({ 0, reader.position(), game });
+
+    // A flip's event has just been read when it is applied, so the reader
+    // already points past it: exactly where a seek to it continues from
+    auto onFlip = [&](int) {
+        flipTimes.push_back(game.timeMs);
+        if (driver.flipsApplied() % interval == 0) {
+            keyframes.push_back({ driver.flipsApplied(), reader.position(), game });
+        }
+    };
+    for (;;) {
+        if (!driver.applyDue(game, onFlip)) {
+            error = driver.error();
+            return false;
+        }
+        if (driver.finished() || game.gameComplete) {
+            return true;
+        }
+        GameEvent event = stepGame(game, SIMULATION_STEP_MS);
+        if (event == GameEvent::TransitionEnded && !advanceLevel(game)) {
+            return true;
+        }
+    }
+}
+
+int ReplayIndex::flipsAt(int64_t timeMs) const {
+    return static_cast<int>(std::upper_bound(flipTimes.begin(), flipTimes.end(), timeMs) - flipTimes.begin());
+}
+
+bool ReplayIndex::seek(ReplayDriver& driver, GameState& game, int flip, std::string& error) const {
+    if (keyframes.empty()) {
+        error = "replay is not indexed";
+        return false;
+    }
+    flip = std::max(0, std::min(flip, flipCount()));
+    auto after = std::upper_bound(keyframes.begin(), keyframes.end(), flip, [](int wanted, const Keyframe& keyframe) {
+        return wanted < keyframe.flip;
+    });
+    const Keyframe& keyframe = *(after - 1);
+    game = keyframe.game;
+    driver.resume(keyframe.position, keyframe.flip);
+
+    // Play on from the snapshot, stopping as soon as the wanted flip is in
+    driver.setFlipLimit(flip);
+    while (driver.flipsApplied() < flip) {
+        if (!driver.applyDue(game)) {
+            driver.setFlipLimit(-1);
+            error = driver.error();
+            return false;
+        }
+        if (driver.flipsApplied() == flip || driver.finished()) {
+            break;
+        }
+        if (stepGame(game, SIMULATION_STEP_MS) == GameEvent::TransitionEnded) {
+            advanceLevel(game);
+        }
+    }
+    driver.setFlipLimit(-1);
+    return true;
+}
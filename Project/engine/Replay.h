@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "GameState.h"
+#include "MappedFile.h"
+
+// Recorded games. A replay holds the game's seed, which deals every board,
+// and each accepted flip with the simulation time it happened at, so
+// playing the flips back at the same times reproduces the game exactly.
+//
+// File (integers are unsigned LEB128 varints unless noted):
+//   header  "MMRP", uint32 version (little-endian), seed
+//   events  uint8 type, time since the previous event in ms, then
+//             LevelStart: level, pairs, cols, rows
+//             Flip:       card index
+//             End:        nothing; written when the recording is closed
+
+enum class ReplayEventType : uint8_t {
+    LevelStart = 1,
+    Flip = 2,
+    End = 3
+};
+
+// One decoded event; only the fields of its type are set
+struct ReplayEvent {
+    ReplayEventType type = ReplayEventType::End;
+    int64_t timeMs = 0;                   // Simulation time, GameState::timeMs
+    int level = 0;                        // LevelStart
+    LevelConfig config = {};              // LevelStart
+    int card = -1;                        // Flip
+};
+
+// Where a reader is in its replay, to come back to with seek()
+struct ReplayPosition {
+    size_t offset = 0;                    // Bytes from the first event to the next one
+    int64_t timeMs = 0;                   // Time of the last event read
+};
+
+// Writes a replay through an in-memory buffer that is flushed in large blocks
+class ReplayWriter {
+public:
+    ~ReplayWriter();
+
+    // Create the file and write the header; returns false if it cannot be created
+    bool open(const std::string& path, uint64_t seed);
+
+    bool isOpen() const {
+        return out.is_open();
+    }
+
+    void levelStart(int64_t timeMs, int level, const LevelConfig& config);
+    void flip(int64_t timeMs, int card);
+
+    // Write the End event and everything buffered; returns false on a write error
+    bool close(int64_t timeMs);
+
+private:
+    // Start an event, encoding its time against the previous one
+    void beginEvent(ReplayEventType type, int64_t timeMs);
+
+    // Write the buffer out once it holds a full block
+    void flushIfFull();
+
+    std::ofstream out;
+    std::string buffer;
+    int64_t lastTimeMs = 0;
+};
+
+// Decodes a replay straight from a mapped file or a caller's buffer
+class ReplayReader {
+public:
+    // Map a replay file and check its header
+    bool open(const std::string& path, std::string& error);
+
+    // Read a replay held in memory, which must outlive the reader
+    bool openMemory(const unsigned char* data, size_t size, std::string& error);
+
+    uint64_t seed() const {
+        return gameSeed;
+    }
+
+    // Size of the whole replay in bytes
+    size_t size() const {
+        return bytes;
+    }
+
+    // Decode the next event; returns false at the end or on a malformed event, see error()
+    bool next(ReplayEvent& event);
+
+    // Go back to the first event
+    void rewind();
+
+    ReplayPosition position() const;
+
+    // Continue reading from a position this replay's reader returned earlier
+    void seek(const ReplayPosition& position);
+
+    // Why next() stopped early, or an empty string
+    const std::string& error() const {
+        return failure;
+    }
+
+private:
+    MappedFile file;
+    const unsigned char* begin = nullptr;
+    const unsigned char* cursor = nullptr;
+    const unsigned char* end = nullptr;
+    size_t bytes = 0;
+    uint64_t gameSeed = 0;
+    int64_t timeMs = 0;
+    bool ended = false;
+    std::string failure;
+};
+
+// Feeds a replay's flips into a game at their recorded times. Call
+// applyDue before every stepGame, and advance levels on TransitionEnded as
+// usual; the game then goes through exactly the recorded states.
+class ReplayDriver {
+public:
+    explicit ReplayDriver(ReplayReader& reader);
+
+    // Start the game with the recorded seed
+    void start(GameState& game);
+
+    // Continue from a point where the reader was at position and flips
+    // flips had been applied; the game must be in the state it was in then
+    void resume(const ReplayPosition& position, int flips);
+
+    // Make applyDue stop once this many flips have been applied in all; -1 for no limit
+    void setFlipLimit(int flips) {
+        flipLimit = flips;
+    }
+
+    int flipsApplied() const {
+        return flips;
+    }
+
+    // Apply every flip recorded at or before the game's current time, calling
+    // onFlip(card) for each; returns false if the replay does not fit the game
+    template <typename OnFlip>
+    bool applyDue(GameState& game, OnFlip onFlip);
+
+    bool applyDue(GameState& game) {
+        return applyDue(game, [](int) {});
+    }
+
+    // Every event was applied
+    bool finished() const {
+        return done;
+    }
+
+    // Why the replay did not fit, or an empty string
+    const std::string& error() const {
+        return failure;
+    }
+
+private:
+    // Check and apply one event; returns false if it does not fit the game
+    bool apply(GameState& game, const ReplayEvent& event);
+
+    ReplayReader& reader;
+    ReplayEvent pending;
+    bool hasPending = false;
+    bool done = false;
+    int flips = 0;
+    int flipLimit = -1;
+    std::string failure;
+};
+
+template <typename OnFlip>
+bool ReplayDriver::applyDue(GameState& game, OnFlip onFlip) {
+    while (!done && flips != flipLimit) {
+        if (!hasPending) {
+            if (!reader.next(pending)) {
+                done = true;
+                failure = reader.error();
+                return failure.empty();
+            }
+            hasPending = true;
+        }
+        if (pending.timeMs > game.timeMs) {
+            return true;
+        }
+        hasPending = false;
+        if (pending.type == ReplayEventType::End) {
+            done = true;
+            return true;
+        }
+        if (!apply(game, pending)) {
+            return false;
+        }
+        if (pending.type == ReplayEventType::Flip) {
+            flips++;
+            onFlip(pending.card);
+        }
+    }
+    return true;
+}
+
+// Play a whole replay on a fresh game without any view, stopping once the
+// last event was applied and the game has settled; returns false if the
+// replay does not fit the game
+bool replayHeadless(ReplayReader& reader, GameState& game, std::string& error);
+
+// Game snapshots taken every few flips of a replay. Seeking restores the
+// last snapshot at or before the wanted flip, found by binary search, and
+// replays only the flips after it, so a jump costs at most one interval of
+// simulation however long the game was.
+class ReplayIndex {
+public:
+    // Play the whole replay once, taking a snapshot every interval flips
+    bool build(ReplayReader& reader, int interval, std::string& error);
+
+    // Flips in the replay
+    int flipCount() const {
+        return static_cast<int>(flipTimes.size());
+    }
+
+    // Time of a flip, counting from 1
+    int64_t flipTime(int flip) const {
+        return flipTimes[flip - 1];
+    }
+
+    // Number of flips made at or before timeMs
+    int flipsAt(int64_t timeMs) const;
+
+    // Put the game right after its flip-th flip (0 for the start of the game)
+    // and the driver where it continues from there
+    bool seek(ReplayDriver& driver, GameState& game, int flip, std::string& error) const;
+
+private:
+    // Game state after a number of flips and where the replay continues from it
+    struct Keyframe {
+        int flip;
+        ReplayPosition position;
+        GameState game;
+    };
+
+    std::vector<Keyframe> keyframes;      // By flip, the first at flip 0
+    std::vector<int64_t> flipTimes;       // Time of every flip, in order
+};
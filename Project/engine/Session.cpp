@@ -0,0 +1,90 @@
+#include "Session.h"
+
+#include <algorithm>
+
+// Send a message to the player. One whose fields the protocol cannot carry,
+// such as a game of more moves than MESSAGE_FIELD_MAX, ends the connection
+// as a full buffer does rather than reach the player as some other value.
+static void writeMessage(MessageBuffer& out, const Message& message) {
+    if (!encodeMessage(out, message)) {
+        out.overflowed = true;
+    }
+}
+
+// Tell the player about the board that was just dealt
+static void writeLevelStarted(const GameState& game, MessageBuffer& out) {
+    Message message;
+    message.type = MessageType::LevelStarted;
+    message.level = game.level;
+    message.config = LEVELS[game.level];
+    writeMessage(out, message);
+}
+
+void GameSession::start(uint64_t seed, int64_t nowMs, MessageBuffer& out) {
+    startGame(game, seed);
+    lastMs = nowMs;
+    totalMoves = 0;
+    writeLevelStarted(game, out);
+}
+
+void GameSession::flip(int card, int64_t nowMs, MessageBuffer& out) {
+    // A flip made after the delay ran out must see the pair already turned back
+    advance(nowMs, out);
+    Message reply;
+    reply.card = card;
+    if (applyFlip(game, card) == GameEvent::Flipped) {
+        reply.type = MessageType::Revealed;
+        reply.value = game.cards.values[card];
+    }
+    else {
+        reply.type = MessageType::Rejected;
+    }
+    writeMessage(out, reply);
+}
+
+int64_t GameSession::deadline() const {
+    if (!waiting()) {
+        return -1;
+    }
+    if (game.delayActive) {
+        return lastMs + FLIP_BACK_DELAY_MS - game.delayElapsedMs;
+    }
+    return lastMs + LEVEL_TRANSITION_MS - game.transitionElapsedMs;
+}
+
+void GameSession::advance(int64_t nowMs, MessageBuffer& out) {
+    // Run each timer to its end at most, so the time left over after one
+    // counts toward the next: a level's transition starts when its last
+    // pair was resolved, not when the session was next looked at
+    while (game.gameStarted && lastMs < nowMs) {
+        int64_t end = deadline();
+        int64_t until = end >= 0 ? std::min(end, nowMs) : nowMs;
+
+        // The pair is cleared when it is resolved, so note it first
+        int first = game.flippedCards[0];
+        int second = game.flippedCards[1];
+        GameEvent event = stepGame(game, static_cast<int>(std::min<int64_t>(until - lastMs, LEVEL_TRANSITION_MS)));
+        lastMs = until;
+
+        Message message;
+        if (event == GameEvent::Match || event == GameEvent::Mismatch) {
+            message.type = event == GameEvent::Match ? MessageType::Match : MessageType::Mismatch;
+            message.card = first;
+            message.other = second;
+            writeMessage(out, message);
+
+            if (game.gameComplete) {
+                message = Message();
+                message.type = MessageType::GameComplete;
+                message.moves = totalMoves + game.moves;
+                writeMessage(out, message);
+                completed++;
+            }
+        }
+        else if (event == GameEvent::TransitionEnded && !game.gameComplete) {
+            totalMoves += game.moves;
+            advanceLevel(game);
+            writeLevelStarted(game, out);
+        }
+    }
+}
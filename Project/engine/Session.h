@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include "GameState.h"
+#include "Protocol.h"
+
+// One player's game on a server. The session holds the board, checks
+// every flip against the game's rules and writes the messages the player
+// is sent. Time comes from the caller in milliseconds on any clock that
+// never runs backwards; the game's timers are brought up to it by every
+// call, so the flip-back delay and level transition run exactly as in the
+// game however rarely the session is looked at.
+class GameSession {
+public:
+    // Start a new game with the seed, writing its first LevelStarted
+    void start(uint64_t seed, int64_t nowMs, MessageBuffer& out);
+
+    // Turn a card over for the player, writing Revealed or Rejected
+    void flip(int card, int64_t nowMs, MessageBuffer& out);
+
+    // Run the game's timers up to nowMs, writing whatever they resolved
+    void advance(int64_t nowMs, MessageBuffer& out);
+
+    // A flip-back delay or a level transition is running
+    bool waiting() const {
+        return game.gameStarted && !game.gameComplete && (game.delayActive || game.levelComplete);
+    }
+
+    // Time the running timer ends at, or -1 when none is running
+    int64_t deadline() const;
+
+    bool finished() const {
+        return game.gameComplete;
+    }
+
+    // Games this session has completed
+    int gamesCompleted() const {
+        return completed;
+    }
+
+private:
+    GameState game;
+    int64_t lastMs = 0;                   // Time the game's timers have been run up to
+    int totalMoves = 0;                   // Moves on the levels before the current one
+    int completed = 0;
+};
@@ -0,0 +1,126 @@
+#include "Simulation.h"
+
+#include <utility>
+
+// Uniformly chosen card of a non-empty mask
+static int pickFrom(uint64_t mask, Rng& rng) {
+    return nthBit(mask, static_cast<int>(rng.below(static_cast<uint32_t>(popCount(mask)))));
+}
+
+void BitboardPlayer::reset(int cardCount) {
+    board = Bitboard();
+    board.cardCount = cardCount;
+    flipped = 0;
+}
+
+void BitboardPlayer::observe(int index, int) {
+    flipped |= 1ull << index;
+}
+
+void BitboardPlayer::catchUp(const CardStore& cards) {
+    // Only a card turned over since can have been matched
+    forEachBit(flipped, [&](int index) {
+        if (cards.revealed[index]) {
+            board.revealed |= 1ull << index;
+        }
+    });
+    flipped = 0;
+}
+
+int RandomPlayer::pickFirst(const CardStore& cards, Rng& rng) {
+    catchUp(cards);
+    return pickFrom(board.faceDown(), rng);
+}
+
+int RandomPlayer::pickSecond(const CardStore&, int first, Rng& rng) {
+    return pickFrom(board.faceDown() & ~(1ull << first), rng);
+}
+
+MemoryPlayer::MemoryPlayer(int capacity) : capacity(capacity) {
+}
+
+void MemoryPlayer::reset(int cardCount) {
+    BitboardPlayer::reset(cardCount);
+    order.clear();
+}
+
+void MemoryPlayer::observe(int index, int value) {
+    BitboardPlayer::observe(index, value);
+    if (board.known & (1ull << index)) {
+        return;
+    }
+    board.known |= 1ull << index;
+    board.setValue(index, value);
+    if (capacity < 0) {
+        return;
+    }
+
+    // Forget the oldest card once memory is full
+    order.push_back(index);
+    if (static_cast<int>(order.size()) > capacity) {
+        board.known &= ~(1ull << order.front());
+        order.erase(order.begin());
+    }
+}
+
+int MemoryPlayer::pickUnknown(int exclude, Rng& rng) {
+    uint64_t candidates = board.faceDown() & ~(exclude >= 0 ? 1ull << exclude : 0);
+    uint64_t unseen = candidates & ~board.known;
+    return pickFrom(unseen != 0 ? unseen : candidates, rng);
+}
+
+int MemoryPlayer::pickFirst(const CardStore& cards, Rng& rng) {
+    catchUp(cards);
+    // Take a pair whose both cards are remembered
+    uint64_t pairs = board.knownPairs();
+    if (pairs != 0) {
+        return lowestBit(pairs);
+    }
+    return pickUnknown(-1, rng);
+}
+
+int MemoryPlayer::pickSecond(const CardStore& cards, int first, Rng& rng) {
+    uint64_t partner = board.withValue(cards.values[first]) & board.known & board.faceDown() & ~(1ull << first);
+    if (partner != 0) {
+        return lowestBit(partner);
+    }
+    return pickUnknown(first, rng);
+}
+
+std::unique_ptr<Player> makePlayer(const std::string& strategy) {
+    if (strategy == "perfect") {
+        return std::make_unique<MemoryPlayer>();
+    }
+    if (strategy == "random") {
+        return std::make_unique<RandomPlayer>();
+    }
+    const std::string memoryPrefix = "memory:";
+    if (strategy.compare(0, memoryPrefix.size(), memoryPrefix) == 0) {
+        std::string digits = strategy.substr(memoryPrefix.size());
+        if (!digits.empty() && digits.find_first_not_of("0123456789") == std::string::npos && digits.size() < 10) {
+            return std::make_unique<MemoryPlayer>(std::stoi(digits));
+        }
+    }
+    return nullptr;
+}
+
+int playBoard(GameState& game, CardStore&& cards, Player& player, Rng& rng) {
+    int cardCount = cards.size();
+    startLevel(game, 0, std::move(cards));
+    game.gameStarted = true;
+    player.reset(cardCount);
+
+    while (!game.levelComplete) {
+        // The first card's value is visible to the player before it picks the second
+        int first = player.pickFirst(game.cards, rng);
+        applyFlip(game, first);
+        player.observe(first, game.cards.values[first]);
+
+        int second = player.pickSecond(game.cards, first, rng);
+        applyFlip(game, second);
+        player.observe(second, game.cards.values[second]);
+
+        resolveFlipped(game);
+    }
+    return game.moves;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Bitboard.h"
+#include "GameState.h"
+
+// A simulated player. It sees which cards are face up or matched, and the
+// value of each card it turns over through observe(); it must never read
+// the value of a face-down card.
+class Player {
+public:
+    virtual ~Player() = default;
+
+    // Forget everything before a new board with the given number of cards
+    virtual void reset(int cardCount) = 0;
+
+    // Choose the first card of a move, and the second once the first is face up
+    virtual int pickFirst(const CardStore& cards, Rng& rng) = 0;
+    virtual int pickSecond(const CardStore& cards, int first, Rng& rng) = 0;
+
+    // A card was turned face up, showing its value
+    virtual void observe(int index, int value) = 0;
+};
+
+// Players track the board as a bitboard, so they handle boards of up to
+// BITBOARD_MAX_CARDS cards. Its revealed mask holds the matched cards,
+// caught up from the cards turned over since the last move.
+class BitboardPlayer : public Player {
+public:
+    void reset(int cardCount) override;
+    void observe(int index, int value) override;
+
+protected:
+    // Bring board.revealed up to date with the cards turned over since the last call
+    void catchUp(const CardStore& cards);
+
+    Bitboard board;                       // Matched cards, and remembered cards with their values
+    uint64_t flipped = 0;                 // Cards turned over since the last catchUp
+};
+
+// Turns over face-down cards at random and remembers nothing
+class RandomPlayer : public BitboardPlayer {
+public:
+    int pickFirst(const CardStore& cards, Rng& rng) override;
+    int pickSecond(const CardStore& cards, int first, Rng& rng) override;
+};
+
+// Remembers the values of the last capacity cards it saw (all of them when
+// capacity is negative), takes any pair it knows, and otherwise turns over
+// a card it has not seen and completes its pair from memory if it can
+class MemoryPlayer : public BitboardPlayer {
+public:
+    explicit MemoryPlayer(int capacity = -1);
+
+    void reset(int cardCount) override;
+    int pickFirst(const CardStore& cards, Rng& rng) override;
+    int pickSecond(const CardStore& cards, int first, Rng& rng) override;
+    void observe(int index, int value) override;
+
+private:
+    // A random face-down card other than exclude, preferring ones not remembered
+    int pickUnknown(int exclude, Rng& rng);
+
+    int capacity;
+    std::vector<int> order;               // Remembered cards, oldest first, when capacity is limited
+};
+
+// Create a player from a strategy name: "perfect", "random" or "memory:K"
+// for a player that remembers K cards; returns null for an unknown name
+std::unique_ptr<Player> makePlayer(const std::string& strategy);
+
+// Play a dealt board to the end with the game's own rules, comparing each
+// pair at once instead of after the flip-back delay; returns the number of moves
+int playBoard(GameState& game, CardStore&& cards, Player& player, Rng& rng);
@@ -0,0 +1,110 @@
+#include "TimerWheel.h"
+
+TimerWheel::TimerWheel(int64_t startMs) : nodes(SENTINELS), current(startMs) {
+    for (uint32_t i = 0; i < SENTINELS; ++i) {
+        nodes[i].prev = nodes[i].next = nodes[i].list = i;
+    }
+}
+
+TimerId TimerWheel::schedule(int64_t deadlineMs, uint64_t payload) {
+    uint32_t index = freeList;
+    if (index != 0) {
+        freeList = nodes[index].next;
+    }
+    else {
+        index = static_cast<uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    Node& node = nodes[index];
+    node.deadline = std::max(deadlineMs, current + 1);
+    node.payload = payload;
+    place(index);
+    live++;
+    return (static_cast<TimerId>(node.generation) << 32) | index;
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    uint32_t index = static_cast<uint32_t>(id);
+    uint32_t generation = static_cast<uint32_t>(id >> 32);
+    if (index < SENTINELS || index >= nodes.size() || nodes[index].generation != generation) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+void TimerWheel::place(uint32_t index) {
+    // The lowest level whose slots reach the deadline; the top level holds
+    // anything further out and passes it down again until it is in reach
+    int64_t delta = nodes[index].deadline - current;
+    int level = 0;
+    while (level < LEVELS - 1 && delta >= (int64_t(1) << (SLOT_BITS * (level + 1)))) {
+        level++;
+    }
+    int64_t deadline = std::min(nodes[index].deadline, current + (int64_t(1) << (SLOT_BITS * LEVELS)) - 1);
+    uint32_t slot = static_cast<uint32_t>((deadline >> (SLOT_BITS * level)) & (SLOTS - 1));
+    link(index, level * SLOTS + slot);
+    occupied[level] |= uint64_t(1) << slot;
+}
+
+void TimerWheel::link(uint32_t index, uint32_t list) {
+    Node& head = nodes[list];
+    Node& node = nodes[index];
+    node.list = list;
+    node.prev = head.prev;
+    node.next = list;
+    nodes[head.prev].next = index;
+    head.prev = index;
+}
+
+void TimerWheel::unlink(uint32_t index) {
+    Node& node = nodes[index];
+    nodes[node.prev].next = node.next;
+    nodes[node.next].prev = node.prev;
+    uint32_t list = node.list;
+    if (list < EXPIRING && nodes[list].next == list) {
+        occupied[list / SLOTS] &= ~(uint64_t(1) << (list % SLOTS));
+    }
+}
+
+void TimerWheel::release(uint32_t index) {
+    Node& node = nodes[index];
+    node.generation++;
+    node.next = freeList;
+    freeList = index;
+    live--;
+}
+
+void TimerWheel::cascade(int level) {
+    uint32_t slot = static_cast<uint32_t>((current >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint32_t list = level * SLOTS + slot;
+    if ((occupied[level] & (uint64_t(1) << slot)) == 0) {
+        return;
+    }
+    // Every timer here is due within this slot's span, now starting at the
+    // current tick, so each lands in a lower level
+    uint32_t index = nodes[list].next;
+    nodes[list].next = nodes[list].prev = list;
+    occupied[level] &= ~(uint64_t(1) << slot);
+    while (index != list) {
+        uint32_t next = nodes[index].next;
+        place(index);
+        index = next;
+    }
+}
+
+int64_t TimerWheel::msUntilNext(int64_t limitMs) const {
+    if (live == 0) {
+        return limitMs;
+    }
+    // Level 0 slots after the current tick, in tick order
+    int offset = static_cast<int>(current & (SLOTS - 1));
+    uint64_t ahead = offset == SLOTS - 1 ? 0 : occupied[0] >> (offset + 1);
+    if (ahead != 0) {
+        return std::min<int64_t>(limitMs, lowestBit(ahead) + 1);
+    }
+    // Otherwise nothing happens before level 0 wraps and timers move down
+    int64_t untilWrap = SLOTS - offset;
+    return std::min<int64_t>(limitMs, untilWrap);
+}
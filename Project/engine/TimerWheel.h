@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Bitboard.h"
+
+// Identifies a scheduled timer; 0 is never a valid id. Ids of fired or
+// cancelled timers are never confused with live ones.
+using TimerId = uint64_t;
+
+// Hierarchical timing wheel with millisecond ticks. Level 0 has a slot
+// per millisecond for the next 64 ms, and each level above has slots 64
+// times as wide, so five levels cover about twelve days. Scheduling puts
+// a timer straight into its slot and cancelling unlinks it, both O(1);
+// when a level's slot comes round, its timers move down to finer slots.
+// Time only moves in advance(), so it can follow any clock.
+class TimerWheel {
+public:
+    explicit TimerWheel(int64_t startMs = 0);
+
+    // Fire at deadlineMs, handing payload to advance's callback. A deadline
+    // at or before now() fires on the next tick.
+    TimerId schedule(int64_t deadlineMs, uint64_t payload);
+
+    // Stop a timer; returns false if it already fired or was cancelled
+    bool cancel(TimerId id);
+
+    // Move time forward to nowMs, calling onExpire(payload) for every timer
+    // due by then, in order of their ticks. The callback may schedule and
+    // cancel timers.
+    template <typename OnExpire>
+    void advance(int64_t nowMs, OnExpire onExpire);
+
+    // Milliseconds until the wheel next needs advancing, at most limitMs:
+    // the next level 0 timer, or the next move down from a higher level
+    int64_t msUntilNext(int64_t limitMs) const;
+
+    int64_t now() const {
+        return current;
+    }
+
+    // Timers scheduled and not yet fired or cancelled
+    size_t size() const {
+        return live;
+    }
+
+private:
+    static const int LEVELS = 5;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint32_t EXPIRING = LEVELS * SLOTS;     // List timers wait in while they fire
+    static const uint32_t SENTINELS = EXPIRING + 1;
+
+    // A timer, or the head of a list of them. Lists are circular and
+    // doubly linked through node indices; the first SENTINELS nodes are
+    // the slot lists' heads and never hold a timer.
+    struct Node {
+        int64_t deadline = 0;
+        uint64_t payload = 0;
+        uint32_t prev = 0;
+        uint32_t next = 0;
+        uint32_t generation = 1;          // Bumped whenever the node is freed
+        uint32_t list = 0;                // Head of the list the node is on
+    };
+
+    // Put a timer in the slot its deadline falls into, seen from the current tick
+    void place(uint32_t index);
+
+    void link(uint32_t index, uint32_t list);
+    void unlink(uint32_t index);
+
+    // Move a slot's timers down to finer slots
+    void cascade(int level);
+
+    // Free a node whose timer fired or was cancelled
+    void release(uint32_t index);
+
+    // Handle the tick just reached: move timers down, then fire level 0's slot
+    template <typename OnExpire>
+    void tick(OnExpire& onExpire);
+
+    std::vector<Node> nodes;
+    uint32_t freeList = 0;                // First free node, chained through next; 0 when none
+    uint64_t occupied[LEVELS] = {};       // Bit s set when slot s of the level holds timers
+    int64_t current;
+    size_t live = 0;
+};
+
+template <typename OnExpire>
+void TimerWheel::advance(int64_t nowMs, OnExpire onExpire) {
+    while (current < nowMs) {
+        if (live == 0) {
+            current = nowMs;
+            return;
+        }
+        // With level 0 empty nothing happens before the lowest occupied
+        // level's next slot comes round, so jump to the tick before that
+        if (occupied[0] == 0) {
+            int level = 1;
+            while (level < LEVELS - 1 && occupied[level] == 0) {
+                level++;
+            }
+            current = std::min(nowMs - 1, current | ((int64_t(1) << (SLOT_BITS * level)) - 1));
+        }
+        current++;
+        tick(onExpire);
+    }
+}
+
+template <typename OnExpire>
+void TimerWheel::tick(OnExpire& onExpire) {
+    for (int level = LEVELS - 1; level >= 1; --level) {
+        if ((current & ((int64_t(1) << (SLOT_BITS * level)) - 1)) == 0) {
+            cascade(level);
+        }
+    }
+
+    uint32_t slot = static_cast<uint32_t>(current & (SLOTS - 1));
+    if ((occupied[0] & (uint64_t(1) << slot)) == 0) {
+        return;
+    }
+    // Hand the slot over to the expiring list first, so callbacks that
+    // schedule into this slot or cancel timers in it see consistent lists
+    Node& head = nodes[slot];
+    Node& expiring = nodes[EXPIRING];
+    expiring.next = head.next;
+    expiring.prev = head.prev;
+    nodes[head.next].prev = EXPIRING;
+    nodes[head.prev].next = EXPIRING;
+    for (uint32_t i = expiring.next; i != EXPIRING; i = nodes[i].next) {
+        nodes[i].list = EXPIRING;
+    }
+    head.next = head.prev = slot;
+    occupied[0] &= ~(uint64_t(1) << slot);
+
+    while (nodes[EXPIRING].next != EXPIRING) {
+        uint32_t index = nodes[EXPIRING].next;
+        uint64_t payload = nodes[index].payload;
+        unlink(index);
+        release(index);
+        onExpire(payload);
+    }
+}
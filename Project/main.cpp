@@ -1,210 +1,216 @@
 #include <iostream>
-#include <memory>
 #include <vector>
-#include <stack>
-#include <random>
-#include <ctime>
+#include <algorithm>
+#include <future>
+#include <cstdlib>
+#include <filesystem>
 #include <SFML/Graphics.hpp>
 #include <SFML/Audio.hpp>
-#include <functional> // Required for std::function
+#include "engine/GameState.h"
+#include "engine/Layout.h"
+#include "engine/OptimalPlay.h"
+#include "engine/Replay.h"
+#include "BoardRenderer.h"
+#include "FrameLoop.h"
+#include "AssetLoader.h"
+#include "BackgroundResidency.h"
+#include "TextureManager.h"
 
 using namespace std;
 
-// Node structure for linked list
-struct CardNode {
-    int value;                        // Card value
-    bool revealed;                    // Whether the card is revealed
-    sf::Sprite sprite;                // Sprite for rendering
-    sf::RectangleShape shadow;        // Shadow for elevation effect
-    shared_ptr<CardNode> next;        // Pointer to the next node
-};
-
-// Linked list class for managing cards
-class CardList {
-public:
-    shared_ptr<CardNode> head;        // Head of the linked list
-
-    // Add a card to the list
-    void addCard(int value, const sf::Texture& backTexture) {
-        auto newCard = make_shared<CardNode>();
-        newCard->value = value;
-        newCard->revealed = false;
-        newCard->sprite.setTexture(backTexture);
-        newCard->shadow.setSize(sf::Vector2f(backTexture.getSize().x, backTexture.getSize().y));
-        newCard->shadow.setFillColor(sf::Color(0, 0, 0, 150)); // Semi-transparent black with more opacity
-        newCard->next = head;
-        head = newCard;
-    }
+// Lay the board out on its level grid and rebuild the card quads
+void setCardPositions(const GameState& game, BoardRenderer& boardRenderer, GridLayout& boardLayout, sf::RenderWindow& window, float spacing) {
+    const LevelConfig& config = LEVELS[game.level];
+    boardLayout = computeGridLayout(static_cast<float>(window.getSize().x), static_cast<float>(window.getSize().y), config.cols, config.rows, spacing);
+    boardRenderer.setBoard(game.cards, boardLayout);
+}
 
-    // Shuffle the linked list
-    void shuffle() {
-        vector<shared_ptr<CardNode>> nodes;
-        for (auto temp = head; temp != nullptr; temp = temp->next) {
-            nodes.push_back(temp);
-        }
+// Board for the next level, dealt and laid out while the level complete banner shows
+struct NextLevel {
+    CardStore cards;
+    GridLayout layout;
+    sf::Vector2u windowSize;          // Window size the layout was computed for
+};
 
-        std::shuffle(nodes.begin(), nodes.end(), default_random_engine(static_cast<unsigned>(time(nullptr))));
+// Deal and lay out the next level's board and build its quads on a worker thread
+future<void> prepareNextLevel(const GameState& game, NextLevel& nextLevel, BoardRenderer& boardRenderer, sf::Vector2u windowSize, float spacing) {
+    int level = game.level + 1;
+    uint64_t seed = game.seed;
+    return async(launch::async, [level, seed, windowSize, spacing, &nextLevel, &boardRenderer]() {
+        const LevelConfig& config = LEVELS[level];
+        nextLevel.cards = dealLevel(level, seed);
+        nextLevel.layout = computeGridLayout(static_cast<float>(windowSize.x), static_cast<float>(windowSize.y), config.cols, config.rows, spacing);
+        nextLevel.windowSize = windowSize;
+        boardRenderer.prepareBoard(nextLevel.cards, nextLevel.layout);
+    });
+}
 
-        head = nullptr;
-        for (auto it = nodes.rbegin(); it != nodes.rend(); ++it) {
-            (*it)->next = head;
-            head = *it;
+// Bundle built by memmatch-pack; loose files are used when it is missing
+const char* ASSET_BUNDLE_PATH = "assets.pak";
+
+// Backgrounds decoded at the window size, reused across runs
+const char* IMAGE_CACHE_DIRECTORY = "cache";
+
+// Loose file for a bundle entry, relative to the Project directory the game runs from
+string looseAssetPath(const string& name) {
+    const pair<string, string> folders[] = {
+        { "cards/", "assets/cards/" },
+        { "sounds/", "assets/sounds/" },
+        { "fonts/", "assets/arial-font/" },
+        { "backgrounds/", "../" }
+    };
+    for (const auto& folder : folders) {
+        if (name.compare(0, folder.first.size(), folder.first) == 0) {
+            return folder.second + name.substr(folder.first.size());
         }
     }
+    return name;
+}
 
-    // Traverse and apply a function to each card
-    void traverse(function<void(shared_ptr<CardNode>)> func) {
-        for (auto temp = head; temp != nullptr; temp = temp->next) {
-            func(temp);
-        }
-    }
-};
+// Backgrounds shown at once: the title's and the current level's, plus the next one prefetched
+const size_t BACKGROUND_GPU_BUDGET = 96 * 1024 * 1024;
 
-void setCardPositions(CardList& cardList, sf::RenderWindow& window, int cols, int rows, float spacing) {
-    float cardSize = min((window.getSize().x - (cols + 1) * spacing) / cols, (window.getSize().y - (rows + 1) * spacing) / rows) * 0.75f; // Scale down the card size
-
-    // Calculate the offsets to center the grid
-    float offsetX = (window.getSize().x - (cols * cardSize + (cols - 1) * spacing)) / 2.f;
-    float offsetY = (window.getSize().y - (rows * cardSize + (rows - 1) * spacing)) / 2.f;
-
-    int i = 0;
-    cardList.traverse([&](shared_ptr<CardNode> card) {
-        int row = i / cols;
-        int col = i % cols;
-
-        // Position cards with spacing and offset
-        card->sprite.setPosition(
-            offsetX + col * (cardSize + spacing),
-            offsetY + row * (cardSize + spacing)
-        );
-        card->sprite.setScale(cardSize / card->sprite.getTexture()->getSize().x, cardSize / card->sprite.getTexture()->getSize().y);
-
-        // Position shadow with more offset from the card
-        card->shadow.setPosition(
-            card->sprite.getPosition().x + 10.f,
-            card->sprite.getPosition().y + 10.f
-        );
-        card->shadow.setScale(card->sprite.getScale());
-
-        i++;
-        });
+// Decoded images waiting for upload, including the card faces until the atlas is built
+const size_t DECODED_IMAGE_BUDGET = 64 * 1024 * 1024;
+
+// Background screens: the title, then one per level
+const int TITLE_SCREEN = 0;
+int levelScreen(int level) {
+    return level + 1;
 }
 
-void setupLevel(CardList& cardList, int pairs, const sf::Texture& backTexture) {
-    cardList.head = nullptr;
-    for (int i = 1; i <= pairs; ++i) {
-        for (int j = 0; j < 2; ++j) {  // Two cards per value
-            cardList.addCard(i, backTexture);
+// Value given for a command-line option such as --seed N, or nullptr
+const char* optionValue(int argc, char** argv, const string& option) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (argv[i] == option) {
+            return argv[i + 1];
         }
     }
-    cardList.shuffle();
+    return nullptr;
 }
 
-int main() {
+// Every game is recorded here, named after its seed
+const char* REPLAY_DIRECTORY = "replays";
+
+// Flips between replay snapshots, and flips skipped by one arrow key press
+const int REPLAY_KEYFRAME_INTERVAL = 32;
+const int REPLAY_SCRUB_FLIPS = 10;
+
+int main(int argc, char** argv) {
     // SFML setup
     sf::VideoMode desktop = sf::VideoMode::getDesktopMode();
     sf::RenderWindow window(desktop, "Memory Match Cards", sf::Style::Fullscreen);
-    window.setFramerateLimit(60);
-
-    // Load textures
-    sf::Texture backTexture;
-    if (!backTexture.loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/cards/back.png")) {
-        cerr << "Error loading back texture" << endl;
-        return -1;
-    }
-
-    vector<sf::Texture> cardTextures(12);
+    FramePacer framePacer(60);        // Paces frames instead of setFramerateLimit
+
+    // Decode every asset on a worker pool. The title screen's own assets are
+    // queued first so it can be shown before the rest have finished.
+    AssetBundle bundle;
+    bundle.open(ASSET_BUNDLE_PATH);
+    ImageCache imageCache(IMAGE_CACHE_DIRECTORY);
+    AssetLoader assets(&bundle, &imageCache, looseAssetPath);
+    TextureManager textures;          // Shares identical backgrounds between screens
+    BackgroundResidency backgrounds(assets, textures, BACKGROUND_GPU_BUDGET, DECODED_IMAGE_BUDGET);
+    sf::Vector2u screenSize = window.getSize();
+    backgrounds.addScreen("backgrounds/test4.jpg", "background texture 1", screenSize);
+    backgrounds.addScreen("backgrounds/test3.png", "background texture 3", screenSize);
+    backgrounds.addScreen("backgrounds/test2.jpg", "background texture 2", screenSize);
+    backgrounds.addScreen("backgrounds/test2.jpg", "background texture 4", screenSize);
+    backgrounds.fit(screenSize);
+    backgrounds.enterScreen(TITLE_SCREEN);
+    int fontAsset = assets.loadFont("fonts/arial.ttf", "font");
+
+    int backAsset = assets.loadImage("cards/back.png", "back texture");
+    vector<int> cardAssets;
     for (int i = 1; i <= 12; ++i) {
-        if (!cardTextures[i - 1].loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/cards/" + to_string(i) + ".png")) {
-            cerr << "Error loading card texture " << i << endl;
-            return -1;
-        }
-    }
-
-    // Load background textures
-    sf::Texture backgroundTexture1;
-    if (!backgroundTexture1.loadFromFile("C:/Uni/3rd/Data Structures project/Project/test4.jpg")) {
-        cerr << "Error loading background texture 1" << endl;
-        return -1;
+        cardAssets.push_back(assets.loadImage("cards/" + to_string(i) + ".png", "card texture " + to_string(i)));
     }
-    sf::Sprite backgroundSprite1(backgroundTexture1);
-    backgroundSprite1.setScale(
-        static_cast<float>(window.getSize().x) / backgroundTexture1.getSize().x,
-        static_cast<float>(window.getSize().y) / backgroundTexture1.getSize().y
-    );
 
-    sf::Texture backgroundTexture2;
-    if (!backgroundTexture2.loadFromFile("C:/Uni/3rd/Data Structures project/Project/test2.jpg")) {
-        cerr << "Error loading background texture 2" << endl;
-        return -1;
-    }
-    sf::Sprite backgroundSprite2(backgroundTexture2);
-    backgroundSprite2.setScale(
-        static_cast<float>(window.getSize().x) / backgroundTexture2.getSize().x,
-        static_cast<float>(window.getSize().y) / backgroundTexture2.getSize().y
-    );
+    int flipAsset = assets.loadSound("sounds/flip.wav", "flip sound");
+    int matchAsset = assets.loadSound("sounds/match.wav", "match sound");
+    int levelCompleteAsset = assets.loadSound("sounds/level_complete.wav", "level complete sound");
+    int nextLevelAsset = assets.loadSound("sounds/next_level.wav", "next level sound");
 
-    sf::Texture backgroundTexture3;
-    if (!backgroundTexture3.loadFromFile("C:/Uni/3rd/Data Structures project/Project/test3.png")) {
-        cerr << "Error loading background texture 3" << endl;
-        return -1;
-    }
-    sf::Sprite backgroundSprite3(backgroundTexture3);
-    backgroundSprite3.setScale(
-        static_cast<float>(window.getSize().x) / backgroundTexture3.getSize().x,
-        static_cast<float>(window.getSize().y) / backgroundTexture3.getSize().y
-    );
+    BoardRenderer boardRenderer;
+    int cardImagesLeft = static_cast<int>(cardAssets.size()) + 1;
+    sf::Sound flipSound, matchSound, levelCompleteSound, nextLevelSound;
 
-    sf::Texture backgroundTexture4;
-    if (!backgroundTexture4.loadFromFile("C:/Uni/3rd/Data Structures project/Project/test2.jpg")) {
-        cerr << "Error loading background texture 4" << endl;
-        return -1;
-    }
-    sf::Sprite backgroundSprite4(backgroundTexture4);
-    backgroundSprite4.setScale(
-        static_cast<float>(window.getSize().x) / backgroundTexture4.getSize().x,
-        static_cast<float>(window.getSize().y) / backgroundTexture4.getSize().y
-    );
+    // Upload textures and attach sound buffers as their decodes finish; returns false on a load error
+    auto useFinishedAssets = [&]() {
+        if (!assets.error().empty()) {
+            cerr << "Error loading " << assets.error() << endl;
+            return false;
+        }
 
-    // Load font
-    sf::Font font;
-    if (!font.loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/arial-font/arial.ttf")) {
-        cerr << "Error loading font" << endl;
-        return -1;
-    }
+        for (int asset : assets.takeFinished()) {
+            backgrounds.assetFinished(asset);
+            if (asset == backAsset || find(cardAssets.begin(), cardAssets.end(), asset) != cardAssets.end()) {
+                cardImagesLeft--;
+            }
+            if (asset == flipAsset) flipSound.setBuffer(assets.sound(asset));
+            if (asset == matchAsset) matchSound.setBuffer(assets.sound(asset));
+            if (asset == levelCompleteAsset) levelCompleteSound.setBuffer(assets.sound(asset));
+            if (asset == nextLevelAsset) nextLevelSound.setBuffer(assets.sound(asset));
+        }
 
-    // Load sound effects
-    sf::SoundBuffer flipBuffer;
-    if (!flipBuffer.loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/sounds/flip.wav")) {
-        cerr << "Error loading flip sound" << endl;
-        return -1;
-    }
-    sf::Sound flipSound(flipBuffer);
+        // Pack the back and all faces into one atlas for batched drawing once all are decoded
+        if (cardImagesLeft == 0) {
+            vector<const sf::Image*> cardImages;
+            for (int asset : cardAssets) {
+                cardImages.push_back(&assets.image(asset));
+            }
+            if (!boardRenderer.loadAtlas(assets.image(backAsset), cardImages)) {
+                cerr << "Error creating card atlas" << endl;
+                return false;
+            }
+            // The atlas holds its own copy on the GPU
+            assets.release(backAsset);
+            for (int asset : cardAssets) {
+                assets.release(asset);
+            }
+            cardImagesLeft = -1;
+        }
+        backgrounds.update();
+        return true;
+    };
+
+    // Show a progress bar until the title screen's assets are in
+    sf::RectangleShape progressTrack(sf::Vector2f(window.getSize().x / 2.f, 20.f));
+    progressTrack.setFillColor(sf::Color(75, 0, 130)); // Dark purple
+    progressTrack.setPosition(window.getSize().x / 4.f, window.getSize().y / 2.f - 10.f);
+    sf::RectangleShape progressBar = progressTrack;
+    progressBar.setFillColor(sf::Color(255, 215, 0)); // Gold
+
+    while (!(backgrounds.isResident(TITLE_SCREEN) && assets.isReady(fontAsset))) {
+        sf::Event event;
+        while (window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed)
+                return 0;
+        }
+        if (!useFinishedAssets()) {
+            return -1;
+        }
 
-    sf::SoundBuffer matchBuffer;
-    if (!matchBuffer.loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/sounds/match.wav")) {
-        cerr << "Error loading match sound" << endl;
-        return -1;
+        progressBar.setSize(sf::Vector2f(progressTrack.getSize().x * assets.progress(), progressTrack.getSize().y));
+        window.clear(sf::Color::Black);
+        window.draw(progressTrack);
+        window.draw(progressBar);
+        window.display();
+        framePacer.waitForNextFrame();
     }
-    sf::Sound matchSound(matchBuffer);
-
-    sf::SoundBuffer levelCompleteBuffer;
-    if (!levelCompleteBuffer.loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/sounds/level_complete.wav")) {
-        cerr << "Error loading level complete sound" << endl;
+    if (!useFinishedAssets()) {
         return -1;
     }
-    sf::Sound levelCompleteSound(levelCompleteBuffer);
 
-    sf::SoundBuffer nextLevelBuffer;
-    if (!nextLevelBuffer.loadFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/sounds/next_level.wav")) {
-        cerr << "Error loading next level sound" << endl;
-        return -1;
-    }
-    sf::Sound nextLevelSound(nextLevelBuffer);
+    sf::Font& font = assets.font(fontAsset);
 
     // Load background music
     sf::Music backgroundMusic;
-    if (!backgroundMusic.openFromFile("C:/Uni/3rd/Data Structures project/Project/Project/assets/sounds/background_music.ogg")) {
+    size_t musicSize = 0;
+    const void* musicData = bundle.isOpen() ? bundle.find("sounds/background_music.ogg", musicSize) : nullptr;
+    bool musicOpened = musicData != nullptr
+        ? backgroundMusic.openFromMemory(musicData, musicSize)
+        : backgroundMusic.openFromFile(looseAssetPath("sounds/background_music.ogg"));
+    if (!musicOpened) {
         cerr << "Error loading background music" << endl;
         return -1;
     }
@@ -322,41 +328,85 @@ int main() {
     winMessageShadow.setFillColor(sf::Color(0, 0, 0, 150)); // Semi-transparent black
     winMessageShadow.setPosition(winMessageText.getPosition().x + 5.f, winMessageText.getPosition().y + 5.f);
 
-    // Linked list of cards
-    CardList cardList;
-    bool gameStarted = false;
-    bool level1 = false;
-    bool level2 = false;
-    bool level3 = false;
+    // Game rules and board state
+    GameState game;
+    // --seed N deals every game from N, 0 included; without it each game gets a fresh seed
+    const char* seedOption = optionValue(argc, argv, "--seed");
+    bool seedGiven = seedOption != nullptr;
+    uint64_t requestedSeed = seedGiven ? strtoull(seedOption, nullptr, 10) : 0;
+
+    // --replay FILE plays a recorded game instead of taking clicks
+    ReplayReader replayReader;
+    ReplayDriver replayDriver(replayReader);
+    ReplayIndex replayIndex;
+    ReplayWriter recorder;
+    const char* replayPath = optionValue(argc, argv, "--replay");
+    bool replaying = false;
+    if (replayPath != nullptr) {
+        string error;
+        replaying = replayReader.open(replayPath, error) && replayIndex.build(replayReader, REPLAY_KEYFRAME_INTERVAL, error);
+        if (!replaying) {
+            cerr << "Error loading replay " << replayPath << ": " << error << endl;
+            return -1;
+        }
+        cout << "Replaying " << replayPath << " (seed " << replayReader.seed() << ", " << replayIndex.flipCount()
+             << " flips); Left/Right skip " << REPLAY_SCRUB_FLIPS << " flips, Home/End jump to either end" << endl;
+    }
+    OptimalTable optimalPlay;         // Expected moves under optimal play, to grade each level
+    optimalPlay.solve(LEVELS[LEVEL_COUNT - 1].pairs, 1);
+    GridLayout boardLayout;           // Grid the cards are laid out on
+    FixedStepClock stepClock(SIMULATION_STEP_MS); // Turns frame time into fixed simulation ticks
+    NextLevel nextLevel;              // Next board, prepared during the level transition
+    future<void> nextLevelReady;
 
-    // Stack to manage flipped cards
-    stack<shared_ptr<CardNode>> flippedCards;
-    int matchesFound = 0; // Track the number of matches found
-    sf::Clock clock; // Clock to manage the delay
-    bool delayActive = false;
-    sf::Time delayTime = sf::seconds(0.5); // Delay time for flipping cards back
+    bool assetsReady = false;
 
     // Main game loop
     while (window.isOpen()) {
+        // Keep uploading assets that finish decoding while the title screen shows
+        if (!useFinishedAssets()) {
+            return -1;
+        }
+        bool wasReady = assetsReady;
+        assetsReady = assets.allReady() && cardImagesLeft < 0;
+        if (assetsReady && !wasReady) {
+            cout << "Resident background textures:\n";
+            textures.report(cout);
+            backgrounds.report(cout);
+        }
+
         sf::Event event;
         while (window.pollEvent(event)) {
             if (event.type == sf::Event::Closed)
                 window.close();
 
-            if (!gameStarted) {
+            if (!game.gameStarted) {
                 // Handle button clicks on the title screen
                 if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
                     sf::Vector2i mousePos = sf::Mouse::getPosition(window);
 
-                    if (playButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                        gameStarted = true;
-                        level1 = true;
+                    if (assetsReady && playButton.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
+                        if (replaying) {
+                            replayDriver.start(game);
+                        }
+                        else {
+                            uint64_t seed = seedGiven ? requestedSeed : randomSeed();
+                            string recording = string(REPLAY_DIRECTORY) + "/game-" + to_string(seed) + ".mmr";
+                            error_code ignored;
+                            filesystem::create_directories(REPLAY_DIRECTORY, ignored);
+                            // The clock restarts at 0 with the game, which the first level starts at
+                            startGame(game, seed);
+                            if (recorder.open(recording, seed)) {
+                                recorder.levelStart(game.timeMs, 0, LEVELS[0]);
+                            }
+                            cout << "Game seed " << seed << " (replay with --seed " << seed << " or --replay " << recording << ")" << endl;
+                        }
+                        backgrounds.enterScreen(levelScreen(game.level));
                         levelText.setString("LEVEL 1");
                         levelShadow.setString("LEVEL 1");
                         levelText.setPosition(window.getSize().x / 2.f - levelText.getGlobalBounds().width / 2.f, 20.f);
                         levelShadow.setPosition(levelText.getPosition().x + 5.f, levelText.getPosition().y + 5.f);
-                        setupLevel(cardList, 4, backTexture); // Level 1 with 4 pairs
-                        setCardPositions(cardList, window, 4, 2, 20.f); // 4 columns, 2 rows
+                        setCardPositions(game, boardRenderer, boardLayout, window, 20.f);
                         nextLevelSound.play();
                     }
 
@@ -372,34 +422,9 @@ int main() {
             else {
                 // Handle window resize
                 if (event.type == sf::Event::Resized) {
-                    if (level1) {
-                        setCardPositions(cardList, window, 4, 2, 20.f); // 4 columns, 2 rows
-                    }
-                    else if (level2) {
-                        setCardPositions(cardList, window, 4, 4, 20.f); // 4 columns, 4 rows
-                    }
-                    else if (level3) {
-                        setCardPositions(cardList, window, 6, 4, 20.f); // 6 columns, 4 rows
-                    }
+                    setCardPositions(game, boardRenderer, boardLayout, window, 20.f);
                     closeButtonGame.setPosition(window.getSize().x - 40.f, 10.f);
-                    if (level1) {
-                        backgroundSprite3.setScale(
-                            static_cast<float>(window.getSize().x) / backgroundTexture3.getSize().x,
-                            static_cast<float>(window.getSize().y) / backgroundTexture3.getSize().y
-                        );
-                    }
-                    else if (level2) {
-                        backgroundSprite2.setScale(
-                            static_cast<float>(window.getSize().x) / backgroundTexture2.getSize().x,
-                            static_cast<float>(window.getSize().y) / backgroundTexture2.getSize().y
-                        );
-                    }
-                    else if (level3) {
-                        backgroundSprite4.setScale(
-                            static_cast<float>(window.getSize().x) / backgroundTexture4.getSize().x,
-                            static_cast<float>(window.getSize().y) / backgroundTexture4.getSize().y
-                        );
-                    }
+                    backgrounds.fit(window.getSize());
                     scoreText.setPosition(window.getSize().x - 200.f, window.getSize().y - 50.f);
                     scoreShadow.setPosition(scoreText.getPosition().x + 5.f, scoreText.getPosition().y + 5.f);
                     matchMessageText.setPosition(20.f, window.getSize().y - 50.f);
@@ -408,157 +433,163 @@ int main() {
                     levelShadow.setPosition(levelText.getPosition().x + 5.f, levelText.getPosition().y + 5.f);
                     winMessageText.setPosition(window.getSize().x / 2.f - winMessageText.getGlobalBounds().width / 2.f, window.getSize().y - 100.f);
                     winMessageShadow.setPosition(winMessageText.getPosition().x + 5.f, winMessageText.getPosition().y + 5.f);
-                    }
+                }
 
-                    // Mouse click to flip cards
-                    if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
-                        sf::Vector2i mousePos = sf::Mouse::getPosition(window);
+                // Mouse click to flip cards
+                if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                    sf::Vector2i mousePos = sf::Mouse::getPosition(window);
 
-                        if (closeButtonGame.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                            window.close();
-                        }
+                    if (closeButtonGame.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
+                        window.close();
+                    }
 
-                        cardList.traverse([&](shared_ptr<CardNode> card) {
-                            if (!card->revealed && card->sprite.getGlobalBounds().contains(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y))) {
-                                card->revealed = true;
-                                card->sprite.setTexture(cardTextures[card->value - 1]);
-                                flippedCards.push(card);
-                                flipSound.play();
-
-                                if (flippedCards.size() == 2) {
-                                    delayActive = true;
-                                    clock.restart();
-                                }
-                            }
-                            });
+                    // Map the click straight to a grid cell instead of testing every card
+                    int index = boardLayout.cardAt(static_cast<float>(mousePos.x), static_cast<float>(mousePos.y), game.cards.size());
+                    if (!replaying && index >= 0 && applyFlip(game, index) == GameEvent::Flipped) {
+                        flipSound.play();
+                        recorder.flip(game.timeMs, index);
                     }
                 }
-            }
 
-            if (gameStarted) {
-                // Check if delay is active and if the delay time has passed
-                if (delayActive && clock.getElapsedTime() >= delayTime) {
-                    auto firstCard = flippedCards.top();
-                    flippedCards.pop();
-                    auto secondCard = flippedCards.top();
-                    flippedCards.pop();
-
-                    if (firstCard->value != secondCard->value) {
-                        firstCard->revealed = secondCard->revealed = false;
-                        firstCard->sprite.setTexture(backTexture);
-                        secondCard->sprite.setTexture(backTexture);
-                        matchMessageText.setString("No match. Try again.");
+                // Scrub through a replay
+                if (replaying && event.type == sf::Event::KeyPressed) {
+                    int flip = -1;
+                    if (event.key.code == sf::Keyboard::Left)
+                        flip = max(0, replayDriver.flipsApplied() - REPLAY_SCRUB_FLIPS);
+                    else if (event.key.code == sf::Keyboard::Right)
+                        flip = replayDriver.flipsApplied() + REPLAY_SCRUB_FLIPS;
+                    else if (event.key.code == sf::Keyboard::Home)
+                        flip = 0;
+                    else if (event.key.code == sf::Keyboard::End)
+                        flip = replayIndex.flipCount();
+                    string error;
+                    if (flip >= 0 && !replayIndex.seek(replayDriver, game, flip, error)) {
+                        cerr << "Replay stopped: " << error << endl;
+                        replaying = false;
                     }
-                    else {
-                        matchesFound++;
-                        matchMessageText.setString("You found a match!");
-                        scoreText.setString("Score: " + to_string(matchesFound));
-                        matchSound.play();
-                        cout << "You found a match! Total matches: " << matchesFound << endl;
+                    else if (flip >= 0) {
+                        // The board may be on another level now; a board prepared for the old one is dropped
+                        if (nextLevelReady.valid()) {
+                            nextLevelReady.get();
+                        }
+                        setCardPositions(game, boardRenderer, boardLayout, window, 20.f);
+                        backgrounds.enterScreen(levelScreen(game.level));
+                        string levelName = game.levelComplete ? "" : "LEVEL " + to_string(game.level + 1);
+                        levelText.setString(levelName);
+                        levelShadow.setString(levelName);
+                        levelText.setPosition(window.getSize().x / 2.f - levelText.getGlobalBounds().width / 2.f, 20.f);
+                        levelShadow.setPosition(levelText.getPosition().x + 5.f, levelText.getPosition().y + 5.f);
+                        scoreText.setString("Score: " + to_string(game.matchesFound));
+                        matchMessageText.setString("");
+                        if (game.levelComplete && !game.gameComplete) {
+                            nextLevelReady = prepareNextLevel(game, nextLevel, boardRenderer, window.getSize(), 20.f);
+                        }
+                        cout << "Replay at flip " << replayDriver.flipsApplied() << " of " << replayIndex.flipCount() << endl;
                     }
-
-                    delayActive = false;
                 }
+            }
+        }
 
-                // Render the game
-                window.clear(sf::Color::White); // Clear with white color
-                if (level1) {
-                    window.draw(backgroundSprite3);
-                }
-                else if (level2) {
-                    window.draw(backgroundSprite2);
-                }
-                else if (level3) {
-                    window.draw(backgroundSprite4);
-                }
-                cardList.traverse([&](shared_ptr<CardNode> card) {
-                    window.draw(card->shadow); // Draw shadow first
-                    window.draw(card->sprite); // Draw card on top of shadow
-                    });
-                window.draw(closeButtonGame);
-                window.draw(scoreShadow);
-                window.draw(scoreText);
-                window.draw(matchMessageShadow);
-                window.draw(matchMessageText);
-                window.draw(levelShadow);
-                window.draw(levelText);
+        // Simulate in fixed ticks so timers fire at the same tick whatever the frame rate
+        int ticks = stepClock.beginFrame();
+        for (int tick = 0; tick < ticks; ++tick) {
+            // Recorded flips go in at the tick they were made at
+            if (replaying && game.gameStarted && !replayDriver.applyDue(game, [&](int) { flipSound.play(); })) {
+                cerr << "Replay stopped: " << replayDriver.error() << endl;
+                replaying = false;
             }
-            else {
-                // Render the title screen
-                window.clear(sf::Color::Black); // Clear with black color
-                window.draw(backgroundSprite1);
-                window.draw(titleShadow);
-                window.draw(titleText);
-                window.draw(playButtonShadow);
-                window.draw(playButton);
-                window.draw(playButtonText);
-                window.draw(exitButtonShadow);
-                window.draw(exitButton);
-                window.draw(exitButtonText);
-                window.draw(closeButtonTitle);
+            GameEvent gameEvent = stepGame(game, SIMULATION_STEP_MS);
+
+            if (gameEvent == GameEvent::Mismatch) {
+                matchMessageText.setString("No match. Try again.");
             }
+            else if (gameEvent == GameEvent::Match) {
+                matchMessageText.setString("You found a match!");
+                scoreText.setString("Score: " + to_string(game.matchesFound));
+                matchSound.play();
+                cout << "You found a match! Total matches: " << game.matchesFound << endl;
+
+                // Show the banner and use the transition to prepare the next board
+                if (game.levelComplete) {
+                    cout << "Congratulations! You've completed Level " << game.level + 1 << "!\n";
+                    cout << "You took " << game.moves << " moves; optimal play averages "
+                         << optimalPlay.expectedMoves(LEVELS[game.level].pairs) << "\n";
+                    levelCompleteSound.play();
+                    levelText.setString("");
+                    levelShadow.setString("");
+                    if (!game.gameComplete) {
+                        nextLevelReady = prepareNextLevel(game, nextLevel, boardRenderer, window.getSize(), 20.f);
+                    }
+                }
+            }
+            else if (gameEvent == GameEvent::TransitionEnded) {
+                if (game.gameComplete) {
+                    window.close();
+                    break;
+                }
 
-            window.display();
+                // Swap in the prepared board; it only needs laying out again if the window was resized meanwhile
+                nextLevelReady.get();
+                advanceLevel(game, move(nextLevel.cards));
+                boardRenderer.commitBoard();
+                boardLayout = nextLevel.layout;
+                if (nextLevel.windowSize != window.getSize()) {
+                    setCardPositions(game, boardRenderer, boardLayout, window, 20.f);
+                }
+                recorder.levelStart(game.timeMs, game.level, LEVELS[game.level]);
+                backgrounds.enterScreen(levelScreen(game.level));
+                backgrounds.report(cout);
 
-            // Check for game completion
-            if (matchesFound == 4 && level1) { // Level 1 has 4 pairs
-                cout << "Congratulations! You've completed Level 1!\n";
-                levelCompleteSound.play();
-                levelText.setString("");
-                levelShadow.setString("");
-                window.draw(winMessageShadow);
-                window.draw(winMessageText);
-                window.display();
-                sf::sleep(sf::seconds(3));
-                level1 = false;
-                level2 = true;
-                levelText.setString("LEVEL 2");
-                levelShadow.setString("LEVEL 2");
+                string levelName = "LEVEL " + to_string(game.level + 1);
+                levelText.setString(levelName);
+                levelShadow.setString(levelName);
                 levelText.setPosition(window.getSize().x / 2.f - levelText.getGlobalBounds().width / 2.f, 20.f);
                 levelShadow.setPosition(levelText.getPosition().x + 5.f, levelText.getPosition().y + 5.f);
-                setupLevel(cardList, 8, backTexture); // Level 2 with 8 pairs
-                setCardPositions(cardList, window, 4, 4, 20.f); // 4 columns, 4 rows
-                matchesFound = 0;
                 scoreText.setString("Score: 0");
                 matchMessageText.setString("");
                 nextLevelSound.play();
             }
 
-            if (matchesFound == 8 && level2) { // Level 2 has 8 pairs
-                cout << "Congratulations! You've completed Level 2!\n";
-                levelCompleteSound.play();
-                levelText.setString("");
-                levelShadow.setString("");
-                window.draw(winMessageShadow);
-                window.draw(winMessageText);
-                window.display();
-                sf::sleep(sf::seconds(3));
-                level2 = false;
-                level3 = true;
-                levelText.setString("LEVEL 3");
-                levelShadow.setString("LEVEL 3");
-                levelText.setPosition(window.getSize().x / 2.f - levelText.getGlobalBounds().width / 2.f, 20.f);
-                levelShadow.setPosition(levelText.getPosition().x + 5.f, levelText.getPosition().y + 5.f);
-                setupLevel(cardList, 12, backTexture); // Level 3 with 12 pairs
-                setCardPositions(cardList, window, 6, 4, 20.f); // 6 columns, 4 rows
-                matchesFound = 0;
-                scoreText.setString("Score: 0");
-                matchMessageText.setString("");
-                nextLevelSound.play();
-            }
+            boardRenderer.update(game.cards, SIMULATION_STEP_MS);
+        }
 
-            if (matchesFound == 12 && level3) { // Level 3 has 12 pairs
-                cout << "Congratulations! You've completed Level 3!\n";
-                levelCompleteSound.play();
-                levelText.setString("");
-                levelShadow.setString("");
+        if (game.gameStarted) {
+            // Render the game
+            window.clear(sf::Color::White); // Clear with white color
+            backgrounds.draw(window);
+            boardRenderer.draw(window, stepClock.alpha());
+            window.draw(closeButtonGame);
+            window.draw(scoreShadow);
+            window.draw(scoreText);
+            window.draw(matchMessageShadow);
+            window.draw(matchMessageText);
+            window.draw(levelShadow);
+            window.draw(levelText);
+            if (game.levelComplete) {
                 window.draw(winMessageShadow);
                 window.draw(winMessageText);
-                window.display();
-                sf::sleep(sf::seconds(3));
-                window.close();
             }
         }
+        else {
+            // Render the title screen
+            window.clear(sf::Color::Black); // Clear with black color
+            backgrounds.draw(window);
+            window.draw(titleShadow);
+            window.draw(titleText);
+            window.draw(playButtonShadow);
+            window.draw(playButton);
+            window.draw(playButtonText);
+            window.draw(exitButtonShadow);
+            window.draw(exitButton);
+            window.draw(exitButtonText);
+            window.draw(closeButtonTitle);
+        }
 
-        return 0;
-    }
\ No newline at end of file
+        // Present exactly once per frame
+        window.display();
+        framePacer.waitForNextFrame();
+    }
+
+    recorder.close(game.timeMs);
+    return 0;
+}
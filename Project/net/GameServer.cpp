@@ -0,0 +1,485 @@
+#include "GameServer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Socket.h"
+
+// Events taken from the kernel per wait
+const int EPOLL_BATCH = 256;
+
+// Sessions a worker runs between looks at its sockets, and the longest it
+// waits with nothing to do before checking whether it should stop
+const int TASK_BATCH = 64;
+const int IDLE_WAIT_MS = 100;
+
+static int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Counters have a single writer, so a plain relaxed update is enough
+static void add(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+static void wakeUp(int eventFd) {
+    uint64_t one = 1;
+    ssize_t written = ::write(eventFd, &one, sizeof(one));
+    (void)written;
+}
+
+// Timer payloads name a session slot and the generation it was set in
+static uint64_t timerPayload(uint32_t slot, uint32_t generation) {
+    return static_cast<uint64_t>(generation) << 32 | slot;
+}
+
+static size_t powerOfTwoAtLeast(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+GameServer::GameServer(uint64_t seed, unsigned workerCount, size_t maxSessions)
+    : seed(seed), capacity(powerOfTwoAtLeast(maxSessions)), startTicks(steadyMs()), freeSlots(capacity) {
+    sessions.resize(capacity);
+
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back(new Worker(capacity));
+        workers.back()->rng = Rng(deriveSeed(seed, i));
+    }
+    acceptEpoll = epoll_create1(0);
+}
+
+GameServer::~GameServer() {
+    stopping.store(true);
+    for (auto& worker : workers) {
+        if (worker->thread.joinable()) {
+            wakeUp(worker->wake);
+            worker->thread.join();
+        }
+    }
+    for (auto& session : sessions) {
+        if (session && session->socket >= 0) {
+            ::close(session->socket);
+        }
+    }
+    for (auto& worker : workers) {
+        if (worker->wake >= 0) {
+            ::close(worker->wake);
+        }
+        if (worker->epoll >= 0) {
+            ::close(worker->epoll);
+        }
+    }
+    if (listener >= 0) {
+        ::close(listener);
+    }
+    if (acceptEpoll >= 0) {
+        ::close(acceptEpoll);
+    }
+}
+
+bool GameServer::listen(const std::string& host, int port, std::string& error) {
+    if (acceptEpoll < 0) {
+        error = "cannot create epoll instance";
+        return false;
+    }
+    for (auto& worker : workers) {
+        worker->epoll = epoll_create1(0);
+        worker->wake = eventfd(0, EFD_NONBLOCK);
+        if (worker->epoll < 0 || worker->wake < 0) {
+            error = "cannot create a worker's epoll instance";
+            return false;
+        }
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+        epoll_ctl(worker->epoll, EPOLL_CTL_ADD, worker->wake, &event);
+    }
+    listener = listenTcp(host, port, error);
+    if (listener < 0) {
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listener;
+    epoll_ctl(acceptEpoll, EPOLL_CTL_ADD, listener, &event);
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i]->thread = std::thread(&GameServer::work, this, static_cast<int>(i));
+    }
+    return true;
+}
+
+int GameServer::port() const {
+    return boundPort(listener);
+}
+
+int64_t GameServer::nowMs() const {
+    return steadyMs() - startTicks;
+}
+
+uint64_t GameServer::nextSeed() {
+    uint64_t game = gamesStarted.fetch_add(1, std::memory_order_relaxed) + 1;
+    return seed != 0 ? deriveSeed(seed, game) : randomSeed();
+}
+
+void GameServer::poll(int maxWaitMs) {
+    epoll_event event;
+    if (epoll_wait(acceptEpoll, &event, 1, maxWaitMs) <= 0) {
+        return;
+    }
+    for (;;) {
+        int socket = acceptTcp(listener);
+        if (socket < 0) {
+            return;
+        }
+        uint32_t slot;
+        if (!freeSlots.pop(slot)) {
+            if (sessionCount == capacity) {
+                ::close(socket);
+                acceptTotals.refused++;
+                continue;
+            }
+            slot = sessionCount++;
+            sessions[slot].reset(new Session());
+            sessions[slot]->slot = slot;
+        }
+
+        // The session is still marked scheduled, so nothing else touches
+        // it until its home worker has added the socket
+        Session& session = *sessions[slot];
+        session.socket = socket;
+        session.home = static_cast<int>(nextHome++ % workers.size());
+        Worker& home = *workers[session.home];
+        if (!home.arrivals.push(&session)) {
+            // Holds a slot per session, so only full if the worker has stopped taking them
+            ::close(socket);
+            session.socket = -1;
+            freeSlots.push(slot);
+            acceptTotals.refused++;
+            continue;
+        }
+        wakeUp(home.wake);
+        acceptTotals.accepted++;
+    }
+}
+
+void GameServer::work(int index) {
+    Worker& worker = *workers[index];
+    epoll_event events[EPOLL_BATCH];
+    while (!stopping.load(std::memory_order_relaxed)) {
+        bool idle = worker.tasks.size() == 0;
+        int timeout = 0;
+        if (idle) {
+            timeout = static_cast<int>(worker.timers.msUntilNext(IDLE_WAIT_MS));
+            worker.parked.store(true);
+            parkedCount.fetch_add(1);
+        }
+        int64_t waitStart = steadyNs();
+        int count = epoll_wait(worker.epoll, events, EPOLL_BATCH, timeout);
+        int64_t waitEnd = steadyNs();
+        if (idle) {
+            if (worker.parked.exchange(false)) {
+                parkedCount.fetch_sub(1);
+            }
+            add(worker.counters.idleNs, static_cast<uint64_t>(waitEnd - waitStart));
+        }
+
+        for (int i = 0; i < count; ++i) {
+            Session* session = static_cast<Session*>(events[i].data.ptr);
+            if (session == nullptr) {
+                uint64_t wakeups;
+                ssize_t received = ::read(worker.wake, &wakeups, sizeof(wakeups));
+                (void)received;
+                continue;
+            }
+            if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+                hangUp(worker, *session);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                receive(worker, *session);
+            }
+            // Whoever runs the session next sends the rest of its output
+            else if (events[i].events & EPOLLOUT) {
+                schedule(worker, *session);
+            }
+        }
+
+        Session* arrival;
+        while (worker.arrivals.pop(arrival)) {
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.ptr = arrival;
+            epoll_ctl(worker.epoll, EPOLL_CTL_ADD, arrival->socket, &event);
+            arrival->scheduled.store(false);
+        }
+
+        worker.timers.advance(nowMs(), [&](uint64_t payload) {
+            Session* session = sessions[static_cast<uint32_t>(payload)].get();
+            if (session->generation.load(std::memory_order_relaxed) == static_cast<uint32_t>(payload >> 32)) {
+                schedule(worker, *session);
+            }
+        });
+
+        shareWork(worker);
+        for (int i = 0; i < TASK_BATCH; ++i) {
+            Session* session = worker.tasks.pop();
+            if (session == nullptr) {
+                session = steal(worker, index);
+                if (session == nullptr) {
+                    break;
+                }
+            }
+            run(worker, *session);
+        }
+        add(worker.counters.busyNs, static_cast<uint64_t>(steadyNs() - waitEnd));
+    }
+}
+
+void GameServer::receive(Worker& worker, Session& session) {
+    // Read straight into the input buffer and pass on every whole message;
+    // a partial one waits for the rest of its bytes. A player only ever
+    // waits on an answer or two, so one that fills the inbox is not
+    // playing the game.
+    MessageBuffer& input = session.input;
+    bool delivered = false;
+    for (;;) {
+        unsigned char* space = input.space(MESSAGE_MAX_SIZE);
+        size_t room = input.spaceLeft();
+        ssize_t received = ::read(session.socket, space, room);
+        if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            hangUp(worker, session);
+            return;
+        }
+        if (received < 0) {
+            break;
+        }
+        input.commit(static_cast<size_t>(received));
+        add(worker.counters.bytesIn, static_cast<uint64_t>(received));
+
+        Message message;
+        size_t used;
+        for (;;) {
+            DecodeResult result = decodeMessage(input.data(), input.size(), message, used);
+            if (result == DecodeResult::Incomplete) {
+                break;
+            }
+            if (result == DecodeResult::Malformed || !session.inbox.push(message)) {
+                add(worker.counters.malformed, 1);
+                hangUp(worker, session);
+                return;
+            }
+            input.consume(used);
+            delivered = true;
+        }
+        if (static_cast<size_t>(received) < room) {
+            break;
+        }
+    }
+    if (delivered) {
+        schedule(worker, session);
+    }
+}
+
+void GameServer::schedule(Worker& worker, Session& session) {
+    // Always write the flag, even when it is already set, so that run()'s
+    // exchange reads from this one and sees whatever was queued before it
+    if (!session.scheduled.exchange(true)) {
+        // The deque holds every session, so this only runs inline if it
+        // somehow fills up
+        if (!worker.tasks.push(&session)) {
+            run(worker, session);
+        }
+    }
+}
+
+void GameServer::run(Worker& worker, Session& session) {
+    add(worker.counters.sessionsRun, 1);
+    if (session.closing.load()) {
+        release(worker, session);
+        return;
+    }
+
+    int64_t now = nowMs();
+    int completed = session.game.gamesCompleted();
+    Message message;
+    while (session.inbox.pop(message)) {
+        add(worker.counters.messages, 1);
+        if (message.type == MessageType::StartGame) {
+            session.game.start(nextSeed(), now, session.output);
+        }
+        else if (message.type == MessageType::Flip) {
+            session.game.flip(message.card, now, session.output);
+        }
+    }
+    session.game.advance(now, session.output);
+    add(worker.counters.gamesCompleted, static_cast<uint64_t>(session.game.gamesCompleted() - completed));
+    if (session.output.overflowed) {
+        // Replies have piled up unread; the home worker sees the hang-up
+        add(worker.counters.overflowed, 1);
+        ::shutdown(session.socket, SHUT_RDWR);
+        session.output.clear();
+    }
+    flush(worker, session);
+
+    int64_t deadline = session.game.deadline();
+    if (deadline >= 0 && deadline != session.wakeup) {
+        worker.timers.schedule(deadline, timerPayload(session.slot, session.generation.load(std::memory_order_relaxed)));
+    }
+    session.wakeup = deadline;
+
+    // Messages or a hang-up that arrived while the session ran found it
+    // still scheduled, so take it up again rather than leave them waiting.
+    // No wakeup is lost: schedule() writes the flag with an exchange too,
+    // so either its exchange comes before this one, which then reads from
+    // it and sees the message or hang-up it followed, or after, in which
+    // case it reads false and queues the session itself.
+    session.scheduled.exchange(false);
+    if (session.closing.load() || !session.inbox.empty()) {
+        schedule(worker, session);
+    }
+}
+
+void GameServer::flush(Worker& worker, Session& session) {
+    MessageBuffer& output = session.output;
+    size_t sent = 0;
+    while (sent < output.size()) {
+        // A peer that reset the connection gets EPIPE here rather than the whole server a SIGPIPE
+        ssize_t written = ::send(session.socket, output.data() + sent, output.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                // The home worker sees the hang-up and has the session released
+                ::shutdown(session.socket, SHUT_RDWR);
+                output.clear();
+                return;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    add(worker.counters.bytesOut, sent);
+    output.consume(sent);
+
+    // Only ask for writability while there is something left to write
+    bool wantWrite = !output.empty();
+    if (wantWrite != session.writeRegistered) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        if (wantWrite) {
+            event.events |= EPOLLOUT;
+        }
+        event.data.ptr = &session;
+        epoll_ctl(workers[session.home]->epoll, EPOLL_CTL_MOD, session.socket, &event);
+        session.writeRegistered = wantWrite;
+    }
+}
+
+void GameServer::hangUp(Worker& worker, Session& session) {
+    epoll_ctl(worker.epoll, EPOLL_CTL_DEL, session.socket, nullptr);
+    session.closing.store(true);
+    schedule(worker, session);
+}
+
+void GameServer::release(Worker& worker, Session& session) {
+    ::close(session.socket);
+    session.socket = -1;
+    session.input.clear();
+    session.output.clear();
+    session.inbox.clear();
+    session.writeRegistered = false;
+    session.wakeup = -1;
+    session.game = GameSession();
+    session.closing.store(false);
+    session.generation.fetch_add(1);
+    add(worker.counters.closed, 1);
+
+    // The session stays marked scheduled until the slot is handed out again
+    freeSlots.push(session.slot);
+}
+
+GameServer::Session* GameServer::steal(Worker& worker, int index) {
+    int count = static_cast<int>(workers.size());
+    if (count == 1) {
+        return nullptr;
+    }
+    int first = static_cast<int>(worker.rng.below(static_cast<uint32_t>(count)));
+    for (int i = 0; i < count; ++i) {
+        int victim = (first + i) % count;
+        if (victim == index) {
+            continue;
+        }
+        Session* session = workers[victim]->tasks.steal();
+        if (session != nullptr) {
+            add(worker.counters.steals, 1);
+            return session;
+        }
+    }
+    return nullptr;
+}
+
+void GameServer::shareWork(const Worker& worker) {
+    if (worker.tasks.size() <= 1 || parkedCount.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    for (auto& other : workers) {
+        if (other->parked.exchange(false)) {
+            parkedCount.fetch_sub(1);
+            wakeUp(other->wake);
+            return;
+        }
+    }
+}
+
+int GameServer::connectionCount() const {
+    ServerStats totals = stats();
+    return static_cast<int>(totals.accepted - totals.closed);
+}
+
+ServerStats GameServer::stats() const {
+    ServerStats totals = acceptTotals;
+    totals.gamesStarted = gamesStarted.load(std::memory_order_relaxed);
+    for (auto& worker : workers) {
+        const Counters& counters = worker->counters;
+        totals.closed += counters.closed.load(std::memory_order_relaxed);
+        totals.messagesIn += counters.messages.load(std::memory_order_relaxed);
+        totals.bytesIn += counters.bytesIn.load(std::memory_order_relaxed);
+        totals.bytesOut += counters.bytesOut.load(std::memory_order_relaxed);
+        totals.gamesCompleted += counters.gamesCompleted.load(std::memory_order_relaxed);
+        totals.malformed += counters.malformed.load(std::memory_order_relaxed);
+        totals.overflowed += counters.overflowed.load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+std::vector<WorkerStats> GameServer::workerStats() const {
+    std::vector<WorkerStats> result;
+    for (auto& worker : workers) {
+        const Counters& counters = worker->counters;
+        WorkerStats stats;
+        stats.busyNs = counters.busyNs.load(std::memory_order_relaxed);
+        stats.idleNs = counters.idleNs.load(std::memory_order_relaxed);
+        stats.sessionsRun = counters.sessionsRun.load(std::memory_order_relaxed);
+        stats.steals = counters.steals.load(std::memory_order_relaxed);
+        stats.messages = counters.messages.load(std::memory_order_relaxed);
+        result.push_back(stats);
+    }
+    return result;
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Queues.h"
+#include "Random.h"
+#include "Session.h"
+#include "TimerWheel.h"
+
+// Running totals of a server
+struct ServerStats {
+    uint64_t accepted = 0;                // Connections accepted
+    uint64_t closed = 0;                  // Connections closed, by either side
+    uint64_t refused = 0;                 // Connections turned away because every session slot was taken
+    uint64_t messagesIn = 0;
+    uint64_t bytesIn = 0;
+    uint64_t bytesOut = 0;
+    uint64_t gamesStarted = 0;
+    uint64_t gamesCompleted = 0;
+    uint64_t malformed = 0;               // Connections dropped for sending bytes that are not messages, or too many at once
+    uint64_t overflowed = 0;              // Connections dropped for not reading what they were sent
+};
+
+// What one worker thread has done, for checking that work spreads evenly
+struct WorkerStats {
+    uint64_t busyNs = 0;                  // Time spent on sockets and sessions
+    uint64_t idleNs = 0;                  // Time spent waiting for work
+    uint64_t sessionsRun = 0;             // Times a session was run
+    uint64_t steals = 0;                  // Sessions taken from another worker's queue
+    uint64_t messages = 0;                // Messages handled by the sessions it ran
+};
+
+// Hosts one game session per connection on a pool of worker threads.
+//
+// Each connection's socket lives in one worker's epoll set, its home,
+// which reads and decodes what arrives and passes the messages to the
+// session through a lock-free ring. A session with messages or a due
+// timer is queued as a task on the worker that noticed; workers run their
+// own tasks newest first and steal the oldest task of another worker
+// when they run dry, so a busy worker never holds up sessions another
+// could run. Only the thread that queued a session, and then the one
+// running it, ever touch its game, which needs no lock: the session's
+// scheduled flag hands it from one to the next.
+//
+// Timers sit in a wheel per worker, on the worker that last ran the
+// session; a timer from an earlier run that fires late just runs the
+// session once for nothing.
+class GameServer {
+public:
+    // Games are dealt from seeds derived from seed, or from fresh random
+    // seeds when it is 0. workers of 0 uses one per hardware thread.
+    explicit GameServer(uint64_t seed = 0, unsigned workers = 0, size_t maxSessions = 65536);
+    ~GameServer();
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Start listening on host:port and start the workers; port 0 picks a
+    // free port, see port()
+    bool listen(const std::string& host, int port, std::string& error);
+
+    int port() const;
+
+    // Accept new connections and hand them to the workers, waiting at most
+    // maxWaitMs for one
+    void poll(int maxWaitMs);
+
+    int connectionCount() const;
+
+    ServerStats stats() const;
+
+    std::vector<WorkerStats> workerStats() const;
+
+private:
+    // One player's connection and game
+    struct Session {
+        // Whoever sets this from false to true queues the session, and the
+        // worker that runs it sets it back; while it is set, only that
+        // worker touches the fields below
+        std::atomic<bool> scheduled{true};
+        std::atomic<bool> closing{false};            // The home worker saw the connection end
+        std::atomic<uint32_t> generation{0};         // Bumped when the slot is freed, so old timers can tell
+        uint32_t slot = 0;
+        int socket = -1;
+        int home = 0;                     // Worker whose epoll set holds the socket
+
+        // Home worker only
+        MessageBuffer input{1024};        // Bytes received but not yet decoded
+
+        // Home worker to whoever runs the session
+        SpscRing<Message, 16> inbox;
+
+        // Whoever runs the session
+        MessageBuffer output{4096};       // Bytes encoded but not yet sent
+        bool writeRegistered = false;     // Waiting for the socket to turn writable
+        int64_t wakeup = -1;              // Deadline a timer was last set for
+        GameSession game;
+    };
+
+    // Counters of one worker, written by it alone
+    struct alignas(CACHE_LINE) Counters {
+        std::atomic<uint64_t> busyNs{0};
+        std::atomic<uint64_t> idleNs{0};
+        std::atomic<uint64_t> sessionsRun{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> messages{0};
+        std::atomic<uint64_t> bytesIn{0};
+        std::atomic<uint64_t> bytesOut{0};
+        std::atomic<uint64_t> gamesCompleted{0};
+        std::atomic<uint64_t> closed{0};
+        std::atomic<uint64_t> malformed{0};
+        std::atomic<uint64_t> overflowed{0};
+    };
+
+    struct Worker {
+        explicit Worker(size_t capacity) : tasks(capacity), arrivals(capacity) {
+        }
+
+        int epoll = -1;
+        int wake = -1;                    // eventfd that interrupts the epoll wait
+        std::atomic<bool> parked{false};  // Waiting in epoll with nothing to run
+        WorkStealingDeque<Session> tasks;
+        BoundedQueue<Session*> arrivals;  // New connections to add to the epoll set
+        TimerWheel timers;
+        Rng rng;                          // Picks the worker to steal from
+        Counters counters;
+        std::thread thread;
+    };
+
+    void work(int index);
+
+    // Read from a session's socket and pass the messages on; the worker is its home
+    void receive(Worker& worker, Session& session);
+
+    // Queue a session on this worker unless it is queued or running already
+    void schedule(Worker& worker, Session& session);
+
+    // Run a queued session: handle its messages and timers and send the replies
+    void run(Worker& worker, Session& session);
+
+    // Send as much output as the socket takes, asking the home worker to
+    // report when it takes more
+    void flush(Worker& worker, Session& session);
+
+    // Close the connection and free the slot; the caller holds the session
+    void release(Worker& worker, Session& session);
+
+    // The home worker saw the connection end: stop watching it and have the session released
+    void hangUp(Worker& worker, Session& session);
+
+    // Take a task from another worker, trying each once from a random one
+    Session* steal(Worker& worker, int index);
+
+    // Wake a parked worker when this one has more tasks than it can start now
+    void shareWork(const Worker& worker);
+
+    uint64_t nextSeed();
+
+    int64_t nowMs() const;
+
+    uint64_t seed;
+    size_t capacity;                      // Most sessions at once, a power of two
+    int listener = -1;
+    int acceptEpoll = -1;
+    int64_t startTicks = 0;               // steady_clock reading at construction, in ms
+    std::atomic<bool> stopping{false};
+    std::atomic<int> parkedCount{0};
+    std::atomic<uint64_t> gamesStarted{0};
+    unsigned nextHome = 0;
+    uint32_t sessionCount = 0;            // Slots handed out so far
+    std::vector<std::unique_ptr<Session>> sessions;    // By slot, sized up front
+    BoundedQueue<uint32_t> freeSlots;
+    std::vector<std::unique_ptr<Worker>> workers;
+    ServerStats acceptTotals;             // Counted by the accepting thread
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Lock-free queues for handing work between the server's threads. All of
+// them have a fixed power-of-two capacity chosen up front and never
+// allocate once built.
+
+// Size of a cache line, to keep counters written by different threads apart
+const size_t CACHE_LINE = 64;
+
+// Chase-Lev work-stealing deque. Its owner pushes and pops at the bottom,
+// newest first, while any other thread may steal from the top, oldest
+// first. Holds pointers; push fails when the deque is full.
+template <typename T>
+class WorkStealingDeque {
+public:
+    explicit WorkStealingDeque(size_t capacity) : mask(capacity - 1), slots(new std::atomic<T*>[capacity]) {
+    }
+
+    // Owner only
+    bool push(T* item) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t > static_cast<int64_t>(mask)) {
+            return false;
+        }
+        slots[b & mask].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Owner only; returns null when empty
+    T* pop() {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = slots[b & mask].load(std::memory_order_relaxed);
+        if (t == b) {
+            // Last item: race any thief for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // Any thread; returns null when empty or when another thread got there first
+    T* steal() {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        T* item = slots[t & mask].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // Items in the deque; only a hint while other threads steal
+    int64_t size() const {
+        return bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(CACHE_LINE) std::atomic<int64_t> top{0};
+    alignas(CACHE_LINE) std::atomic<int64_t> bottom{0};
+    size_t mask;
+    std::unique_ptr<std::atomic<T*>[]> slots;
+};
+
+// Bounded queue any number of threads may push to and pop from (Vyukov's
+// sequenced ring). Each slot carries a sequence number saying whether it
+// is ready to be written or read on the current lap.
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) : mask(capacity - 1), cells(new Cell[capacity]) {
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // Returns false when the queue is full
+    bool push(const T& item) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            intptr_t lap = static_cast<intptr_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position);
+            if (lap == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    cell.item = item;
+                    cell.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lap < 0) {
+                return false;
+            }
+            else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false when the queue is empty
+    bool pop(T& item) {
+        size_t position = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[position & mask];
+            intptr_t lap = static_cast<intptr_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<intptr_t>(position + 1);
+            if (lap == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    item = cell.item;
+                    cell.sequence.store(position + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (lap < 0) {
+                return false;
+            }
+            else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T item;
+    };
+
+    alignas(CACHE_LINE) std::atomic<size_t> tail{0};
+    alignas(CACHE_LINE) std::atomic<size_t> head{0};
+    size_t mask;
+    std::unique_ptr<Cell[]> cells;
+};
+
+// Ring for exactly one producer and one consumer at a time. Either side may
+// move to another thread as long as the handover itself synchronizes.
+template <typename T, size_t Capacity>
+class SpscRing {
+public:
+    // Producer only; returns false when full
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        items[t % Capacity] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only; returns false when empty
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = items[h % Capacity];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    // Drop everything; only while neither side is using the ring
+    void clear() {
+        head.store(tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<size_t> tail{0};
+    std::atomic<size_t> head{0};
+    T items[Capacity];
+};
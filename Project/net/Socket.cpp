@@ -0,0 +1,104 @@
+#include "Socket.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Make a socket non-blocking and send small writes immediately
+static bool configureSocket(int socket) {
+    int flags = fcntl(socket, F_GETFL, 0);
+    int on = 1;
+    return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0
+        && setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) == 0;
+}
+
+static bool parseAddress(const std::string& host, int port, sockaddr_in& address, std::string& error) {
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &address.sin_addr) != 1) {
+        error = "not an IPv4 address: " + host;
+        return false;
+    }
+    return true;
+}
+
+int listenTcp(const std::string& host, int port, std::string& error) {
+    sockaddr_in address;
+    if (!parseAddress(host, port, address, error)) {
+        return -1;
+    }
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener < 0) {
+        error = std::strerror(errno);
+        return -1;
+    }
+    int on = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0
+        || fcntl(listener, F_SETFL, O_NONBLOCK) != 0) {
+        error = std::strerror(errno);
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+int connectTcp(const std::string& host, int port, std::string& error) {
+    sockaddr_in address;
+    if (!parseAddress(host, port, address, error)) {
+        return -1;
+    }
+    int connection = socket(AF_INET, SOCK_STREAM, 0);
+    if (connection < 0 || !configureSocket(connection)) {
+        error = std::strerror(errno);
+        if (connection >= 0) {
+            close(connection);
+        }
+        return -1;
+    }
+    if (connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 && errno != EINPROGRESS) {
+        error = std::strerror(errno);
+        close(connection);
+        return -1;
+    }
+    return connection;
+}
+
+int boundPort(int socket) {
+    sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(socket, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        return -1;
+    }
+    return ntohs(address.sin_port);
+}
+
+int acceptTcp(int listener) {
+    int connection = accept(listener, nullptr, nullptr);
+    if (connection < 0) {
+        return -1;
+    }
+    if (!configureSocket(connection)) {
+        close(connection);
+        return -1;
+    }
+    return connection;
+}
+
+long raiseFileLimit() {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return -1;
+    }
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+    getrlimit(RLIMIT_NOFILE, &limit);
+    return static_cast<long>(limit.rlim_cur);
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+
+// Thin helpers over POSIX sockets for the game server and its load client.
+// Every socket they return is non-blocking and has Nagle's algorithm off,
+// since the messages are a few bytes and each one waits for an answer.
+
+// Listen on host:port (port 0 picks a free one); returns the socket or -1
+int listenTcp(const std::string& host, int port, std::string& error);
+
+// Start connecting to host:port; the socket turns writable once connected. Returns -1 on failure
+int connectTcp(const std::string& host, int port, std::string& error);
+
+// Port a socket is bound to, or -1
+int boundPort(int socket);
+
+// Accept a pending connection as a non-blocking socket, or -1 when there is none
+int acceptTcp(int listener);
+
+// Raise the open file limit as far as allowed and return the new limit
+long raiseFileLimit();
@@ -0,0 +1,191 @@
+// Checks the bitboard against the game's card store and rules: conversions
+// both ways, the masks search reads, moves played in step with the game,
+// and Zobrist hashes kept up to date move by move.
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Bitboard.h"
+#include "GameState.h"
+
+using namespace std;
+
+int failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+uint64_t bit(int index) {
+    return 1ull << index;
+}
+
+// A dealt board part way through: some pairs matched, some cards seen
+CardStore dealPartPlayed(int pairs, Rng& rng, uint64_t& known) {
+    CardStore cards;
+    setupLevel(cards, pairs, rng);
+    for (int i = 0; i < cards.size(); ++i) {
+        for (int j = i + 1; j < cards.size(); ++j) {
+            if (cards.values[i] == cards.values[j] && rng.below(3) == 0) {
+                cards.revealed[i] = cards.revealed[j] = 1;
+                cards.matched[i] = cards.matched[j] = 1;
+            }
+        }
+    }
+    known = 0;
+    for (int i = 0; i < cards.size(); ++i) {
+        if (rng.below(2) == 0) {
+            known |= bit(i);
+        }
+    }
+    return cards;
+}
+
+void checkConversion(const CardStore& cards, uint64_t known, const string& name) {
+    Bitboard board;
+    check(toBitboard(cards, board, known), name + ": converts");
+    check(board.cardCount == cards.size(), name + ": card count");
+    for (int i = 0; i < cards.size(); ++i) {
+        check(board.value(i) == cards.values[i], name + ": value of card " + to_string(i));
+        check(((board.revealed >> i) & 1) == cards.revealed[i], name + ": revealed card " + to_string(i));
+        check(((board.matched >> i) & 1) == cards.matched[i], name + ": matched card " + to_string(i));
+        check(((board.known >> i) & 1) == (((known >> i) & 1) | cards.revealed[i]), name + ": known card " + to_string(i));
+    }
+
+    // Masks against a walk over the store
+    uint64_t unseen = 0, pairs = 0;
+    for (int i = 0; i < cards.size(); ++i) {
+        bool seen = ((known >> i) & 1) != 0;
+        if (cards.revealed[i]) {
+            continue;
+        }
+        if (!seen) {
+            unseen |= bit(i);
+            continue;
+        }
+        for (int j = 0; j < cards.size(); ++j) {
+            if (j != i && cards.values[j] == cards.values[i] && !cards.revealed[j] && ((known >> j) & 1)) {
+                pairs |= bit(i);
+            }
+        }
+    }
+    check(board.unseen() == unseen, name + ": unseen cards");
+    check(board.knownPairs() == pairs, name + ": known pairs");
+    for (int value = 1; value <= cards.size() / 2; ++value) {
+        uint64_t withValue = 0;
+        for (int i = 0; i < cards.size(); ++i) {
+            if (cards.values[i] == value) {
+                withValue |= bit(i);
+            }
+        }
+        check(board.withValue(value) == withValue, name + ": cards of value " + to_string(value));
+    }
+
+    CardStore back;
+    fromBitboard(board, back);
+    check(back.values == cards.values && back.revealed == cards.revealed && back.matched == cards.matched, name + ": converts back");
+
+    Bitboard again;
+    toBitboard(back, again, known);
+    check(zobristHash(again) == zobristHash(board), name + ": same board, same hash");
+}
+
+// Play a board to the end with moves from generateMoves, on the bitboard and
+// through the game rules side by side
+void checkPlay(CardStore cards, Rng& rng, const string& name) {
+    Bitboard board;
+    toBitboard(cards, board);
+    uint64_t hash = zobristHash(board);
+
+    GameState game;
+    startLevel(game, 0, move(cards));
+    game.gameStarted = true;
+
+    vector<BitboardMove> moves(BITBOARD_MAX_MOVES);
+    while (!game.levelComplete) {
+        int count = generateMoves(board, moves.data());
+        if (count == 0) {
+            check(false, name + ": moves left on an unfinished board");
+            return;
+        }
+        set<pair<int, int>> distinct;
+        for (int i = 0; i < count; ++i) {
+            BitboardMove candidate = moves[i];
+            check(candidate.first != candidate.second, name + ": move turns over two cards");
+            check(!game.cards.revealed[candidate.first] && !game.cards.revealed[candidate.second], name + ": move turns over face-down cards");
+            distinct.insert(minmax<int>(candidate.first, candidate.second));
+        }
+        check(static_cast<int>(distinct.size()) == count, name + ": each move listed once");
+
+        BitboardMove chosen = moves[rng.below(static_cast<uint32_t>(count))];
+        Bitboard before = board;
+        bool matched = applyMove(board, chosen);
+        applyFlip(game, chosen.first);
+        applyFlip(game, chosen.second);
+        check(matched == (resolveFlipped(game) == GameEvent::Match), name + ": move outcome");
+
+        CardStore played;
+        fromBitboard(board, played);
+        check(played.revealed == game.cards.revealed && played.matched == game.cards.matched, name + ": board after move");
+
+        hash = zobristAfterMove(hash, before, board);
+        check(hash == zobristHash(board), name + ": hash updated after move");
+        if (board.known != before.known) {
+            check(hash != zobristHash(before), name + ": hash changes with the board");
+        }
+    }
+    check(board.matched == board.cardMask(), name + ": every card matched");
+}
+
+void checkLimits() {
+    Bitboard board;
+    CardStore cards;
+    Rng rng(7);
+    setupLevel(cards, BITBOARD_MAX_CARDS / 2, rng);
+    check(toBitboard(cards, board), "a full board converts");
+    check(board.cardMask() == ~0ull, "a full board uses every bit");
+    check(board.withValue(BITBOARD_MAX_CARDS / 2) != 0, "the highest value is found");
+
+    board.cardCount = 3;
+    Bitboard unchanged = board;
+    CardStore tooMany;
+    setupLevel(tooMany, BITBOARD_MAX_CARDS / 2 + 1, rng);
+    check(!toBitboard(tooMany, board), "more than BITBOARD_MAX_CARDS cards are refused");
+
+    CardStore badValue;
+    badValue.addCard(1);
+    badValue.addCard(0);
+    check(!toBitboard(badValue, board), "value 0 is refused");
+    badValue.values[1] = BITBOARD_MAX_VALUE + 1;
+    check(!toBitboard(badValue, board), "a value past BITBOARD_MAX_VALUE is refused");
+    check(board.cardCount == unchanged.cardCount && board.revealed == unchanged.revealed, "a refused store leaves the board alone");
+}
+
+int main() {
+    Rng rng(1);
+    for (int pairs = 1; pairs <= BITBOARD_MAX_CARDS / 2; ++pairs) {
+        for (int trial = 0; trial < 20; ++trial) {
+            string name = to_string(pairs) + " pairs, trial " + to_string(trial);
+            uint64_t known = 0;
+            checkConversion(dealPartPlayed(pairs, rng, known), known, name);
+
+            CardStore fresh;
+            setupLevel(fresh, pairs, rng);
+            checkPlay(move(fresh), rng, name);
+        }
+    }
+    checkLimits();
+
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All bitboard checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,181 @@
+// Checks the wire protocol: every message type encoded and decoded back at
+// the edges of each varint length, fields the protocol cannot carry refused
+// by the encoder, and truncated or malformed input told apart from a whole
+// message by the decoder.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Protocol.h"
+
+using namespace std;
+
+int failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+// Field values where a varint grows a byte, and the ends of the range
+const int EDGE_VALUES[] = { 0, 1, 127, 128, 16383, 16384, MESSAGE_FIELD_MAX };
+
+const MessageType MESSAGE_TYPES[] = {
+    MessageType::StartGame, MessageType::Flip, MessageType::LevelStarted, MessageType::Revealed,
+    MessageType::Match, MessageType::Mismatch, MessageType::Rejected, MessageType::GameComplete
+};
+
+// A message of the given type with every field it carries set to value
+Message makeMessage(MessageType type, int value) {
+    Message message;
+    message.type = type;
+    switch (type) {
+    case MessageType::StartGame:
+        break;
+    case MessageType::Flip:
+    case MessageType::Rejected:
+        message.card = value;
+        break;
+    case MessageType::LevelStarted:
+        message.level = value;
+        message.config = { value, value, value };
+        break;
+    case MessageType::Revealed:
+        message.card = value;
+        message.value = value;
+        break;
+    case MessageType::Match:
+    case MessageType::Mismatch:
+        message.card = value;
+        message.other = value;
+        break;
+    case MessageType::GameComplete:
+        message.moves = value;
+        break;
+    }
+    return message;
+}
+
+bool sameMessage(const Message& a, const Message& b) {
+    return a.type == b.type && a.level == b.level && a.config.pairs == b.config.pairs && a.config.cols == b.config.cols
+        && a.config.rows == b.config.rows && a.card == b.card && a.other == b.other && a.value == b.value && a.moves == b.moves;
+}
+
+string describe(const Message& message, int value) {
+    return "type " + to_string(static_cast<int>(message.type)) + " with fields of " + to_string(value);
+}
+
+void checkRoundTrips() {
+    MessageBuffer stream(64 * 1024);
+    vector<Message> sent;
+    for (MessageType type : MESSAGE_TYPES) {
+        for (int value : EDGE_VALUES) {
+            Message message = makeMessage(type, value);
+            string name = describe(message, value);
+
+            unsigned char bytes[MESSAGE_MAX_SIZE];
+            size_t size = encodeMessage(bytes, message);
+            check(size >= 2 && size <= MESSAGE_MAX_SIZE, name + ": encoded size");
+
+            Message decoded;
+            size_t used = 0;
+            check(decodeMessage(bytes, size, decoded, used) == DecodeResult::Complete, name + ": decodes");
+            check(used == size, name + ": decodes every byte");
+            check(sameMessage(decoded, message), name + ": decodes to the same message");
+
+            // Every prefix is a message still arriving
+            for (size_t prefix = 0; prefix < size; ++prefix) {
+                check(decodeMessage(bytes, prefix, decoded, used) == DecodeResult::Incomplete, name + ": " + to_string(prefix) + " bytes are incomplete");
+            }
+
+            check(encodeMessage(stream, message), name + ": appends to a buffer");
+            sent.push_back(message);
+        }
+    }
+
+    // Back to back in one stream, as they arrive on a socket
+    const unsigned char* data = stream.data();
+    size_t left = stream.size();
+    size_t index = 0;
+    Message decoded;
+    size_t used;
+    while (decodeMessage(data, left, decoded, used) == DecodeResult::Complete) {
+        check(index < sent.size() && sameMessage(decoded, sent[index]), "stream message " + to_string(index));
+        data += used;
+        left -= used;
+        index++;
+    }
+    check(index == sent.size() && left == 0, "stream decodes to the end");
+}
+
+void checkRefusedFields() {
+    for (MessageType type : MESSAGE_TYPES) {
+        if (type == MessageType::StartGame) {
+            continue;
+        }
+        for (int value : { -1, MESSAGE_FIELD_MAX + 1 }) {
+            Message message = makeMessage(type, value);
+            string name = describe(message, value);
+            unsigned char bytes[MESSAGE_MAX_SIZE];
+            check(encodeMessage(bytes, message) == 0, name + ": refused");
+
+            MessageBuffer buffer(64);
+            check(!encodeMessage(buffer, message), name + ": refused by a buffer");
+            check(buffer.empty() && !buffer.overflowed, name + ": buffer left alone");
+        }
+    }
+
+    // One field out of range is enough
+    Message match = makeMessage(MessageType::Match, 3);
+    match.other = -5;
+    unsigned char bytes[MESSAGE_MAX_SIZE];
+    check(encodeMessage(bytes, match) == 0, "a match with one bad card is refused");
+
+    // A buffer without room for a whole message
+    MessageBuffer small(MESSAGE_MAX_SIZE - 1);
+    check(!encodeMessage(small, makeMessage(MessageType::StartGame, 0)), "a full buffer refuses a message");
+    check(small.overflowed && small.empty(), "a full buffer is marked overflowed");
+}
+
+void checkMalformed() {
+    struct Case {
+        const char* name;
+        vector<unsigned char> bytes;
+    };
+    const vector<Case> cases = {
+        { "unknown type", { 0, 0 } },
+        { "unknown server type", { 22, 1, 0 } },
+        { "body shorter than its fields", { static_cast<unsigned char>(MessageType::Revealed), 1, 5 } },
+        { "body longer than its fields can be", { static_cast<unsigned char>(MessageType::Flip), 4, 0x80, 0x80, 0x80, 0 } },
+        { "bytes after the last field", { static_cast<unsigned char>(MessageType::Flip), 2, 5, 5 } },
+        { "field running past the body", { static_cast<unsigned char>(MessageType::Flip), 1, 0x85 } },
+        { "field past MESSAGE_FIELD_MAX", { static_cast<unsigned char>(MessageType::Flip), 3, 0x80, 0x80, 0x04 } },
+        { "body on a message without fields", { static_cast<unsigned char>(MessageType::StartGame), 1, 0 } },
+    };
+    for (const Case& test : cases) {
+        Message message;
+        size_t used;
+        check(decodeMessage(test.bytes.data(), test.bytes.size(), message, used) == DecodeResult::Malformed, string(test.name) + " is malformed");
+    }
+
+    // The header alone is enough to refuse a frame, before its body arrives
+    const unsigned char header[] = { static_cast<unsigned char>(MessageType::Flip), 9 };
+    Message message;
+    size_t used;
+    check(decodeMessage(header, sizeof(header), message, used) == DecodeResult::Malformed, "an oversized body is refused from its header");
+}
+
+int main() {
+    checkRoundTrips();
+    checkRefusedFields();
+    checkMalformed();
+
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All protocol checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Records games the way the window does, with the title screen's ticks
+// before the start and flips made right after it, and checks that
+// replayHeadless plays each recording back to the same game.
+
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "GameState.h"
+#include "Replay.h"
+
+using namespace std;
+
+int failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+// Cards in the order a player turns them over: one mismatched pair to
+// start, then every pair in board order
+vector<int> planFlips(const CardStore& cards) {
+    vector<int> flips;
+    int other = 1;
+    while (cards.values[other] == cards.values[0]) {
+        other++;
+    }
+    flips.push_back(0);
+    flips.push_back(other);
+
+    vector<bool> taken(cards.size(), false);
+    for (int i = 0; i < cards.size(); ++i) {
+        if (taken[i]) {
+            continue;
+        }
+        for (int j = i + 1; j < cards.size(); ++j) {
+            if (!taken[j] && cards.values[j] == cards.values[i]) {
+                taken[i] = taken[j] = true;
+                flips.push_back(i);
+                flips.push_back(j);
+                break;
+            }
+        }
+    }
+    return flips;
+}
+
+// Play a whole game as the window does: the clock runs on the title screen,
+// the game starts on a click, and each tick takes at most one click before
+// stepping the game. Returns the time of every flip.
+vector<int64_t> recordGame(const string& path, uint64_t seed, int titleTicks, GameState& game) {
+    for (int tick = 0; tick < titleTicks; ++tick) {
+        stepGame(game, SIMULATION_STEP_MS);
+    }
+
+    ReplayWriter recorder;
+    check(recorder.open(path, seed), "recording opens");
+    startGame(game, seed);
+    recorder.levelStart(game.timeMs, 0, LEVELS[0]);
+
+    vector<int64_t> flipTimes;
+    vector<int> plan = planFlips(game.cards);
+    size_t next = 0;
+    for (;;) {
+        if (next < plan.size() && applyFlip(game, plan[next]) == GameEvent::Flipped) {
+            recorder.flip(game.timeMs, plan[next]);
+            flipTimes.push_back(game.timeMs);
+            next++;
+        }
+
+        GameEvent event = stepGame(game, SIMULATION_STEP_MS);
+        if (event == GameEvent::Match && game.gameComplete) {
+            break;
+        }
+        if (event == GameEvent::TransitionEnded) {
+            advanceLevel(game);
+            recorder.levelStart(game.timeMs, game.level, LEVELS[game.level]);
+            plan = planFlips(game.cards);
+            next = 0;
+        }
+    }
+    check(recorder.close(game.timeMs), "recording closes");
+    return flipTimes;
+}
+
+void checkRoundTrip(uint64_t seed, int titleTicks) {
+    string name = "seed " + to_string(seed) + " after " + to_string(titleTicks) + " title ticks";
+    string path = (filesystem::temp_directory_path() / ("memmatch-replay-test-" + to_string(seed) + ".mmr")).string();
+
+    GameState recorded;
+    vector<int64_t> flipTimes = recordGame(path, seed, titleTicks, recorded);
+    check(!flipTimes.empty() && flipTimes[0] == 0, name + ": first flip made at the start");
+    check(flipTimes.size() > 1 && flipTimes[1] == SIMULATION_STEP_MS, name + ": second flip made a tick later");
+
+    // Every event keeps the time it was made at
+    ReplayReader reader;
+    string error;
+    check(reader.open(path, error), name + ": replay opens: " + error);
+    check(reader.seed() == seed, name + ": seed");
+    ReplayEvent event;
+    check(reader.next(event) && event.type == ReplayEventType::LevelStart && event.timeMs == 0, name + ": first level starts at 0");
+    size_t flip = 0;
+    while (reader.next(event)) {
+        if (event.type == ReplayEventType::Flip) {
+            check(flip < flipTimes.size() && event.timeMs == flipTimes[flip], name + ": time of flip " + to_string(flip));
+            flip++;
+        }
+    }
+    check(reader.error().empty(), name + ": replay reads to the end: " + reader.error());
+    check(flip == flipTimes.size(), name + ": every flip recorded");
+
+    reader.rewind();
+    GameState replayed;
+    check(replayHeadless(reader, replayed, error), name + ": replays: " + error);
+    check(replayed.gameComplete && replayed.level == recorded.level, name + ": replay completes the game");
+    check(replayed.moves == recorded.moves && replayed.timeMs == recorded.timeMs, name + ": replay ends as recorded");
+    check(replayed.cards.matched == recorded.cards.matched, name + ": replayed board");
+
+    std::remove(path.c_str());
+}
+
+int main() {
+    for (uint64_t seed = 1; seed <= 20; ++seed) {
+        checkRoundTrip(seed, 0);
+        checkRoundTrip(seed, static_cast<int>(seed) * 37);
+    }
+
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All replay checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,221 @@
+// Checks the timer wheel against a plain list of deadlines: every timer
+// fires exactly at its deadline and in tick order, across the boundaries
+// where timers move down a level, however far each advance jumps; and
+// timers cancelled or scheduled from inside the callbacks behave.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "Random.h"
+#include "TimerWheel.h"
+
+using namespace std;
+
+int failures = 0;
+
+void check(bool ok, const string& what) {
+    if (!ok) {
+        cerr << "FAILED: " << what << endl;
+        failures++;
+    }
+}
+
+// Width of one slot at each level, as the wheel lays them out
+int64_t levelSpan(int level) {
+    return int64_t(1) << (6 * level);
+}
+
+// A timer as the test expects it to behave
+struct Expected {
+    int64_t deadline = 0;
+    TimerId id = 0;
+    bool cancelled = false;
+    int64_t firedAt = -1;                 // Wheel time it fired at, -1 until then
+    int fires = 0;
+};
+
+// Schedules timers, remembers when each should fire, and checks every firing
+class Checker {
+public:
+    Checker(int64_t startMs, const string& name) : wheel(startMs), name(name) {
+    }
+
+    int add(int64_t deadline) {
+        Expected timer;
+        timer.deadline = max(deadline, wheel.now() + 1);
+        timer.id = wheel.schedule(deadline, timers.size());
+        timers.push_back(timer);
+        return static_cast<int>(timers.size()) - 1;
+    }
+
+    bool cancel(int timer) {
+        bool cancelled = wheel.cancel(timers[timer].id);
+        if (cancelled) {
+            timers[timer].cancelled = true;
+        }
+        return cancelled;
+    }
+
+    // Advance to nowMs, running extra(payload) inside each callback
+    template <typename Extra>
+    void advance(int64_t nowMs, Extra extra) {
+        wheel.advance(nowMs, [&](uint64_t payload) {
+            Expected& timer = timers[payload];
+            check(!timer.cancelled, name + ": cancelled timer " + to_string(payload) + " fired");
+            check(wheel.now() == timer.deadline, name + ": timer " + to_string(payload) + " due at " + to_string(timer.deadline)
+                  + " fired at " + to_string(wheel.now()));
+            check(wheel.now() >= lastFired, name + ": timer " + to_string(payload) + " fired out of order");
+            lastFired = wheel.now();
+            timer.firedAt = wheel.now();
+            timer.fires++;
+            extra(payload);
+        });
+        check(wheel.now() == nowMs, name + ": wheel reached " + to_string(nowMs));
+    }
+
+    void advance(int64_t nowMs) {
+        advance(nowMs, [](uint64_t) {});
+    }
+
+    // Every timer due by now fired once, and nothing else did
+    void checkAll() {
+        size_t pending = 0;
+        for (size_t i = 0; i < timers.size(); ++i) {
+            const Expected& timer = timers[i];
+            bool due = !timer.cancelled && timer.deadline <= wheel.now();
+            check(timer.fires == (due ? 1 : 0), name + ": timer " + to_string(i) + " due at " + to_string(timer.deadline)
+                  + " fired " + to_string(timer.fires) + " times by " + to_string(wheel.now()));
+            if (!timer.cancelled && !due) {
+                pending++;
+            }
+        }
+        check(wheel.size() == pending, name + ": " + to_string(pending) + " timers left");
+    }
+
+    TimerWheel wheel;
+    vector<Expected> timers;
+
+private:
+    string name;
+    int64_t lastFired = 0;
+};
+
+// Deadlines on and either side of every level's slot boundaries
+void checkBoundaries(int64_t start) {
+    string name = "boundaries from " + to_string(start);
+    Checker checker(start, name);
+    for (int level = 1; level <= 5; ++level) {
+        for (int64_t multiple : { int64_t(1), int64_t(2), int64_t(63) }) {
+            for (int64_t nudge = -1; nudge <= 1; ++nudge) {
+                int64_t offset = multiple * levelSpan(level) + nudge;
+                checker.add(start + offset);
+                // Also aligned to the wheel's own boundaries rather than the start
+                checker.add((start / levelSpan(level) + multiple) * levelSpan(level) + nudge);
+            }
+        }
+    }
+    checker.add(start - 5);                 // Already due: fires on the next tick
+    checker.add(start + 3 * levelSpan(5));  // Past the top level's reach
+
+    // Small steps through the first ticks, then bigger jumps
+    int64_t now = start;
+    for (int i = 0; i < 200; ++i) {
+        checker.advance(++now);
+    }
+    for (int64_t step : { levelSpan(1) + 1, levelSpan(2) - 1, levelSpan(3), levelSpan(4) + 7 }) {
+        for (int i = 0; i < 5; ++i) {
+            now += step;
+            checker.advance(now);
+            checker.checkAll();
+        }
+    }
+    checker.advance(start + 4 * levelSpan(5));
+    checker.checkAll();
+}
+
+// Many random timers and cancels, advanced by random steps or by msUntilNext
+void checkRandom(uint64_t seed, bool followNext) {
+    string name = string(followNext ? "msUntilNext" : "random steps") + ", seed " + to_string(seed);
+    Rng rng(seed);
+    int64_t start = static_cast<int64_t>(rng.below(1u << 30));
+    Checker checker(start, name);
+    int64_t now = start;
+    for (int round = 0; round < 200; ++round) {
+        for (int i = 0; i < 50; ++i) {
+            int level = static_cast<int>(rng.below(5));
+            checker.add(now + static_cast<int64_t>(rng.below(static_cast<uint32_t>(levelSpan(level + 1)))));
+        }
+        for (int i = 0; i < 10; ++i) {
+            int timer = static_cast<int>(rng.below(static_cast<uint32_t>(checker.timers.size())));
+            bool live = !checker.timers[timer].cancelled && checker.timers[timer].fires == 0;
+            check(checker.cancel(timer) == live, name + ": cancel of timer " + to_string(timer));
+        }
+        int64_t step = followNext ? checker.wheel.msUntilNext(1 << 20) : 1 + static_cast<int64_t>(rng.below(1u << (1 + rng.below(20))));
+        now += step;
+        checker.advance(now);
+    }
+    checker.checkAll();
+    now += levelSpan(5);
+    checker.advance(now);
+    checker.checkAll();
+    check(checker.wheel.size() == 0, name + ": wheel empty at the end");
+}
+
+// Callbacks that cancel, schedule and reschedule timers
+void checkCallbacks() {
+    string name = "callbacks";
+    Checker checker(500, name);
+    int sameTick = checker.add(1000);
+    int cancelledSameTick = checker.add(1000);
+    int cancelledLater = checker.add(1000 + levelSpan(2) + 5);
+    int periodic = checker.add(1100);
+    int periodicFires = 0;
+    vector<int> added;
+
+    checker.advance(1000 + 5 * levelSpan(3), [&](uint64_t payload) {
+        int timer = static_cast<int>(payload);
+        if (timer == sameTick) {
+            // The other timer of this tick is waiting to fire; cancelling it must stop it
+            check(checker.cancel(cancelledSameTick), name + ": cancel a timer due on the same tick");
+            check(checker.cancel(cancelledLater), name + ": cancel a later timer");
+            check(!checker.cancel(sameTick), name + ": a timer that is firing cannot be cancelled");
+            added.push_back(checker.add(checker.wheel.now()));                    // Fires on the next tick
+            added.push_back(checker.add(checker.wheel.now() + levelSpan(1)));     // Right on a level boundary
+            added.push_back(checker.add(checker.wheel.now() + levelSpan(3) - 1));
+        }
+        if (timer == periodic) {
+            // Reschedule every 999 ms, crossing level 1 and 2 boundaries
+            periodicFires++;
+            if (periodicFires < 300) {
+                periodic = checker.add(1100 + periodicFires * 999);
+            }
+        }
+    });
+    checker.checkAll();
+    check(periodicFires == 300, name + ": rescheduled timer fired " + to_string(periodicFires) + " times");
+    check(added.size() == 3 && checker.timers[added[0]].firedAt == 1001, name + ": timer scheduled for now fires on the next tick");
+    check(!checker.cancel(sameTick) && !checker.cancel(cancelledSameTick), name + ": fired and cancelled ids stay dead");
+
+    // A freed node reused by a new timer does not answer to the old id
+    int reused = checker.add(checker.wheel.now() + 10);
+    check(!checker.wheel.cancel(checker.timers[cancelledLater].id), name + ": stale id after reuse");
+    check(checker.cancel(reused), name + ": new timer on a reused node cancels");
+}
+
+int main() {
+    for (int64_t start : { int64_t(0), int64_t(1), int64_t(4095), int64_t(262143), int64_t(1000003), levelSpan(5) - 2 }) {
+        checkBoundaries(start);
+    }
+    for (uint64_t seed = 1; seed <= 10; ++seed) {
+        checkRandom(seed, false);
+        checkRandom(seed, true);
+    }
+    checkCallbacks();
+
+    if (failures > 0) {
+        cerr << failures << " checks failed" << endl;
+        return 1;
+    }
+    cout << "All timer wheel checks passed" << endl;
+    return 0;
+}
@@ -0,0 +1,270 @@
+// memmatch-analyze: aggregate play statistics over many recorded games.
+//
+//   memmatch-analyze [--threads N] PATH...
+//
+// Each PATH is a replay file or a directory searched for *.mmr replays.
+// Files are handed out to the threads one at a time, mapped and decoded in
+// place; decoding an event allocates nothing, and each thread deals boards
+// into one reused card store. Every thread adds into its own totals, which
+// are merged pairwise in parallel once all files are read.
+//
+// Reported per level: moves per completed level, time per flip, and the
+// mismatch rate of every grid position laid out as the board is.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GameState.h"
+#include "Histogram.h"
+#include "Replay.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+// Flip gaps are counted in buckets this wide, and longer gaps in the last one
+const int FLIP_TIME_BUCKET_MS = 10;
+const int FLIP_TIME_LIMIT_MS = 60000;
+
+// Totals for one level over every replay read
+struct LevelStats {
+    uint64_t started = 0;                 // Replays that reached the level
+    uint64_t completed = 0;               // Replays that found every pair on it
+    Histogram moves;                      // Moves taken by each completed level
+    Histogram flipTimes;                  // Time since the previous flip or the level start, in buckets
+    vector<uint64_t> turns;               // Moves that turned over each position
+    vector<uint64_t> mismatches;          // Moves that turned over each position and missed
+
+    explicit LevelStats(int cards = 0) : turns(cards), mismatches(cards) {
+    }
+
+    void merge(const LevelStats& other) {
+        started += other.started;
+        completed += other.completed;
+        moves.merge(other.moves);
+        flipTimes.merge(other.flipTimes);
+        for (size_t i = 0; i < turns.size(); ++i) {
+            turns[i] += other.turns[i];
+            mismatches[i] += other.mismatches[i];
+        }
+    }
+};
+
+// One thread's totals
+struct Analysis {
+    uint64_t files = 0;
+    uint64_t failed = 0;                  // Files that could not be read or did not fit the levels
+    uint64_t bytes = 0;
+    uint64_t events = 0;
+    vector<LevelStats> levels;
+
+    Analysis() {
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            levels.emplace_back(2 * LEVELS[level].pairs);
+        }
+    }
+
+    void merge(const Analysis& other) {
+        files += other.files;
+        failed += other.failed;
+        bytes += other.bytes;
+        events += other.events;
+        for (int level = 0; level < LEVEL_COUNT; ++level) {
+            levels[level].merge(other.levels[level]);
+        }
+    }
+};
+
+// Add one replay's events to the totals; returns false if the replay is
+// malformed or was recorded with other levels
+bool analyzeReplay(ReplayReader& reader, CardStore& cards, Analysis& analysis) {
+    ReplayEvent event;
+    LevelStats* stats = nullptr;
+    int first = -1;                       // First card of the move in progress
+    int moves = 0;
+    int pairsLeft = 0;
+    int64_t lastTimeMs = 0;
+
+    while (reader.next(event)) {
+        analysis.events++;
+        if (event.type == ReplayEventType::LevelStart) {
+            if (event.level < 0 || event.level >= LEVEL_COUNT || event.config.pairs != LEVELS[event.level].pairs
+                || event.config.cols != LEVELS[event.level].cols || event.config.rows != LEVELS[event.level].rows) {
+                return false;
+            }
+            dealLevel(cards, event.level, reader.seed());
+            stats = &analysis.levels[event.level];
+            stats->started++;
+            first = -1;
+            moves = 0;
+            pairsLeft = LEVELS[event.level].pairs;
+            lastTimeMs = event.timeMs;
+        }
+        else if (event.type == ReplayEventType::Flip) {
+            if (stats == nullptr || event.card >= cards.size()) {
+                return false;
+            }
+            int64_t gap = min<int64_t>(event.timeMs - lastTimeMs, FLIP_TIME_LIMIT_MS);
+            stats->flipTimes.add(static_cast<int>(gap / FLIP_TIME_BUCKET_MS));
+            lastTimeMs = event.timeMs;
+
+            // Only accepted flips are recorded, so they alternate first and second card
+            if (first < 0) {
+                first = event.card;
+                continue;
+            }
+            moves++;
+            stats->turns[first]++;
+            stats->turns[event.card]++;
+            if (cards.values[first] == cards.values[event.card]) {
+                if (--pairsLeft == 0) {
+                    stats->completed++;
+                    stats->moves.add(moves);
+                }
+            }
+            else {
+                stats->mismatches[first]++;
+                stats->mismatches[event.card]++;
+            }
+            first = -1;
+        }
+    }
+    return reader.error().empty();
+}
+
+// Analyze the files handed out through next until none are left
+void analyzeFiles(const vector<string>& paths, atomic<size_t>& next, Analysis& analysis) {
+    ReplayReader reader;
+    CardStore cards;
+    string error;
+    for (size_t i = next++; i < paths.size(); i = next++) {
+        analysis.files++;
+        if (!reader.open(paths[i], error)) {
+            analysis.failed++;
+            continue;
+        }
+        analysis.bytes += reader.size();
+        if (!analyzeReplay(reader, cards, analysis)) {
+            analysis.failed++;
+        }
+    }
+}
+
+// Merge every thread's totals into the first, pairing them up in rounds
+// so each round's merges run side by side
+void mergeAll(vector<Analysis>& parts) {
+    for (size_t stride = 1; stride < parts.size(); stride *= 2) {
+        vector<thread> mergers;
+        for (size_t i = 0; i + stride < parts.size(); i += 2 * stride) {
+            mergers.emplace_back([&parts, i, stride]() { parts[i].merge(parts[i + stride]); });
+        }
+        for (auto& merger : mergers) {
+            merger.join();
+        }
+    }
+}
+
+void printLevel(int level, const LevelStats& stats) {
+    const LevelConfig& config = LEVELS[level];
+    cout << "Level " << level + 1 << " (" << config.cols << "x" << config.rows << ", " << config.pairs << " pairs): "
+         << stats.started << " played, " << stats.completed << " completed\n";
+
+    uint64_t completed = stats.moves.total();
+    if (completed > 0) {
+        cout << fixed << setprecision(2) << "  moves mean " << stats.moves.mean()
+             << ", p50 " << stats.moves.percentile(0.5, completed) << ", p90 " << stats.moves.percentile(0.9, completed)
+             << ", p99 " << stats.moves.percentile(0.99, completed) << "\n";
+    }
+
+    uint64_t flips = stats.flipTimes.total();
+    if (flips > 0) {
+        cout << "  " << flips << " flips, time per flip mean " << setprecision(0) << stats.flipTimes.mean() * FLIP_TIME_BUCKET_MS
+             << " ms, p50 " << stats.flipTimes.percentile(0.5, flips) * FLIP_TIME_BUCKET_MS
+             << " ms, p90 " << stats.flipTimes.percentile(0.9, flips) * FLIP_TIME_BUCKET_MS << " ms\n";
+    }
+
+    // Positions are numbered row by row, as GridLayout lays the cards out
+    cout << "  mismatch rate by position (%):\n";
+    for (int row = 0; row < config.rows; ++row) {
+        cout << "   ";
+        for (int col = 0; col < config.cols; ++col) {
+            int index = row * config.cols + col;
+            if (index >= 2 * config.pairs || stats.turns[index] == 0) {
+                cout << setw(7) << "-";
+                continue;
+            }
+            cout << setw(7) << setprecision(1) << 100.0 * stats.mismatches[index] / stats.turns[index];
+        }
+        cout << "\n";
+    }
+    cout << endl;
+}
+
+int main(int argc, char** argv) {
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    vector<string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            try {
+                threads = static_cast<unsigned>(stoul(argv[++i]));
+            }
+            catch (const exception&) {
+                cerr << "Expected a number for --threads, got " << argv[i] << endl;
+                return 2;
+            }
+        }
+        else {
+            inputs.push_back(argument);
+        }
+    }
+    if (inputs.empty() || threads < 1) {
+        cerr << "usage: memmatch-analyze [--threads N] PATH..." << endl;
+        return 2;
+    }
+
+    // Sorted so a run reads the files in the same order every time
+    vector<string> paths;
+    for (const string& input : inputs) {
+        error_code error;
+        if (!fs::is_directory(input, error)) {
+            paths.push_back(input);
+            continue;
+        }
+        for (const auto& entry : fs::recursive_directory_iterator(input, error)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".mmr") {
+                paths.push_back(entry.path().string());
+            }
+        }
+    }
+    sort(paths.begin(), paths.end());
+
+    auto start = chrono::steady_clock::now();
+    atomic<size_t> next(0);
+    vector<Analysis> parts(threads);
+    vector<thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back(analyzeFiles, cref(paths), ref(next), ref(parts[t]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    mergeAll(parts);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const Analysis& total = parts[0];
+    cout << total.files << " replays (" << total.failed << " unreadable), " << total.events << " events, "
+         << fixed << setprecision(1) << total.bytes / 1048576.0 << " MiB in " << setprecision(2) << seconds << " s ("
+         << setprecision(0) << total.files / max(seconds, 1e-9) << " replays/s, "
+         << total.events / max(seconds, 1e-9) << " events/s) on " << threads << " threads\n" << endl;
+    for (int level = 0; level < LEVEL_COUNT; ++level) {
+        printLevel(level, total.levels[level]);
+    }
+    return total.failed == 0 ? 0 : 1;
+}
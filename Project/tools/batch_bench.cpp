@@ -0,0 +1,138 @@
+// memmatch-batch-bench: compare the SIMD batch simulator with the scalar one.
+//
+//   memmatch-batch-bench [--pairs N] [--boards N] [--seed N]
+//
+// Every board is played by both engines, and a sample is also played
+// through the game's own rules (applyFlip/resolveFlipped) by an equivalent
+// player; all three must agree on every board's move count.
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "BatchSim.h"
+#include "Simulation.h"
+
+using namespace std;
+
+// The batch strategy played through Player: known pairs first, then unseen cards in board order
+class OrderedPlayer : public Player {
+public:
+    void reset(int cardCount) override {
+        known.assign(cardCount, 0);
+    }
+
+    int pickFirst(const CardStore& cards, Rng&) override {
+        for (int i = 0; i < cards.size(); ++i) {
+            if (!cards.revealed[i] && known[i] != 0 && partner(cards, i) >= 0) {
+                return i;
+            }
+        }
+        return nextUnseen(cards);
+    }
+
+    int pickSecond(const CardStore& cards, int first, Rng&) override {
+        int index = partner(cards, first);
+        return index >= 0 ? index : nextUnseen(cards);
+    }
+
+    void observe(int index, int value) override {
+        known[index] = value;
+    }
+
+private:
+    // Another face-down card known to match the card at index, or -1
+    int partner(const CardStore& cards, int index) const {
+        for (int i = 0; i < cards.size(); ++i) {
+            if (i != index && !cards.revealed[i] && known[i] == known[index]) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int nextUnseen(const CardStore& cards) const {
+        for (int i = 0; i < cards.size(); ++i) {
+            if (!cards.revealed[i] && known[i] == 0) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    vector<int> known;
+};
+
+// Seconds taken by the fastest of a few runs
+template <typename Run>
+double timeBest(Run run) {
+    double best = 1e30;
+    for (int attempt = 0; attempt < 3; ++attempt) {
+        auto start = chrono::steady_clock::now();
+        run();
+        best = min(best, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    int pairs = 12;
+    int boards = 1 << 20;
+    uint64_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        if (option == "--pairs") pairs = stoi(argv[i + 1]);
+        else if (option == "--boards") boards = stoi(argv[i + 1]);
+        else if (option == "--seed") seed = stoull(argv[i + 1]);
+        else {
+            cerr << "usage: memmatch-batch-bench [--pairs N] [--boards N] [--seed N]" << endl;
+            return 2;
+        }
+    }
+    if (pairs < 1 || pairs > BATCH_MAX_PAIRS || boards < 1) {
+        cerr << "--pairs must be 1.." << BATCH_MAX_PAIRS << " and --boards at least 1" << endl;
+        return 2;
+    }
+
+    Rng rng(seed);
+    BoardBatch batch;
+    batch.deal(boards, pairs, rng);
+    double dealSeconds = timeBest([&]() { batch.deal(boards, pairs, rng); });
+
+    vector<int> scalarMoves(boards), batchMoves(boards);
+    double scalarSeconds = timeBest([&]() { playBatchScalar(batch, scalarMoves.data()); });
+    double batchSeconds = timeBest([&]() { playBatch(batch, batchMoves.data()); });
+
+    if (scalarMoves != batchMoves) {
+        cerr << "Batch and scalar results differ" << endl;
+        return 1;
+    }
+
+    // Replay a sample through the game rules
+    OrderedPlayer player;
+    GameState game;
+    int sample = min(boards, 10000);
+    for (int b = 0; b < sample; ++b) {
+        CardStore cards;
+        for (int i = 0; i < 2 * pairs; ++i) {
+            cards.addCard(batch.values[static_cast<size_t>(b) * batch.stride + i]);
+        }
+        if (playBoard(game, move(cards), player, rng) != scalarMoves[b]) {
+            cerr << "Board " << b << " differs from the game rules" << endl;
+            return 1;
+        }
+    }
+
+    long long turns = 0;
+    for (int moves : scalarMoves) {
+        turns += moves;
+    }
+    cout << boards << " boards of " << pairs << " pairs, " << turns << " turns, mean "
+         << static_cast<double>(turns) / boards << " moves; " << sample << " checked against the game rules\n";
+    cout << "deal:    " << boards / dealSeconds / 1e6 << " M boards/s\n";
+    cout << "scalar:  " << turns / scalarSeconds / 1e6 << " M turns/s\n";
+    cout << "batch:   " << turns / batchSeconds / 1e6 << " M turns/s (" << batchLaneCount() << " lanes, "
+         << scalarSeconds / batchSeconds << "x)" << endl;
+    return 0;
+}
@@ -0,0 +1,522 @@
+// memmatch-loadgen: play many games against a memmatch-server at once.
+//
+//   memmatch-loadgen [--host ADDRESS] [--port N] [--clients N] [--games N] [--strategy NAMES]
+//                    [--think-ms N] [--think-spread X] [--seed N]
+//
+// Opens --clients connections and has each play --games full games, all
+// three levels, as a simulated player. --strategy names one player
+// ("perfect", "random" or "memory:K", as in memmatch-sim) or a
+// comma-separated mix handed out to the clients in turn. Players think
+// before every flip for a log-normal time, as people do: the median is
+// --think-ms (0 flips as soon as the server answers) and --think-spread
+// is the log-normal's sigma, so most flips are quick and a few take
+// several times as long. A second flip comes faster than a first, since
+// the player has already started looking. All connections share one
+// epoll loop, and the think times one timer wheel.
+//
+// Reports games and messages per second, anything the server rejected or
+// broke off, and latency percentiles for each kind of reply. Latency runs
+// from when the server could first have sent the reply: the request for a
+// Revealed, Rejected or a game's first LevelStarted, and the end of the
+// flip-back delay or level transition for the rest. A connection's first
+// LevelStarted also waits for the server to take on the connection, which
+// shows when many connect at once. The load client shares the machine with
+// the server, so latency includes its own time getting round to the reply.
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "GameState.h"
+#include "Histogram.h"
+#include "Protocol.h"
+#include "Simulation.h"
+#include "Socket.h"
+#include "TimerWheel.h"
+
+using namespace std;
+
+// Share of the think time a player takes over a second flip, and the longest any flip waits
+const double SECOND_FLIP_THINK = 0.5;
+const double THINK_LIMIT_MS = 60000;
+
+// Replies the latency report covers, in the order it lists them. Server
+// message types are numbered consecutively from LevelStarted.
+const MessageType REPLY_TYPES[] = {
+    MessageType::LevelStarted, MessageType::Revealed, MessageType::Rejected,
+    MessageType::Match, MessageType::Mismatch, MessageType::GameComplete
+};
+const int REPLY_TYPE_COUNT = 6;
+
+// One simulated player and its view of the board: which cards are face up,
+// and no values but the ones the server revealed
+struct Client {
+    int index = 0;
+    int socket = -1;
+    bool connected = false;
+    bool writeRegistered = true;          // Waiting for the socket to turn writable
+    MessageBuffer input{1024};
+    MessageBuffer output{1024};
+    unique_ptr<Player> player;
+    Rng rng;
+    CardStore board;
+    int first = -1;                       // First card of the move in progress
+    int pairsLeft = 0;
+    int gamesLeft = 0;
+    int64_t requestUs = 0;                // When the last StartGame or Flip was sent
+    int64_t secondFlipUs = 0;             // When the second card of the last pair was asked for
+    int64_t levelDoneUs = 0;              // When the final match of the last level arrived
+};
+
+// Totals over every client
+struct LoadStats {
+    uint64_t messagesOut = 0;
+    uint64_t messagesIn = 0;
+    uint64_t flips = 0;
+    uint64_t gamesCompleted = 0;
+    uint64_t rejected = 0;
+    uint64_t connectFailures = 0;
+    uint64_t disconnects = 0;             // Connections the server closed early
+    uint64_t malformed = 0;
+    uint64_t overflowed = 0;              // Connections with more to send than their buffer holds
+    HdrHistogram latency[REPLY_TYPE_COUNT];    // Microseconds, by reply type
+};
+
+// Log-normal think times
+struct ThinkTime {
+    double medianMs = 0;
+    double spread = 0.6;
+};
+
+// What every client shares
+struct LoadRun {
+    ThinkTime think;
+    TimerWheel timers;                    // Flips waiting on their player's think time, by client index
+    LoadStats stats;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    int64_t nowUs() const {
+        return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+    }
+};
+
+int replyIndex(MessageType type) {
+    return static_cast<int>(type) - static_cast<int>(MessageType::LevelStarted);
+}
+
+const char* messageName(MessageType type) {
+    switch (type) {
+    case MessageType::StartGame: return "StartGame";
+    case MessageType::Flip: return "Flip";
+    case MessageType::LevelStarted: return "LevelStarted";
+    case MessageType::Revealed: return "Revealed";
+    case MessageType::Match: return "Match";
+    case MessageType::Mismatch: return "Mismatch";
+    case MessageType::Rejected: return "Rejected";
+    case MessageType::GameComplete: return "GameComplete";
+    }
+    return "?";
+}
+
+// Standard normal draw by the Box-Muller transform, from the client's own
+// generator so a seed repeats a run
+double normalDraw(Rng& rng) {
+    double u1 = (static_cast<double>(rng.next() >> 11) + 1.0) / 9007199254740992.0;
+    double u2 = static_cast<double>(rng.next() >> 11) / 9007199254740992.0;
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+
+// Milliseconds a player thinks before a flip
+int64_t thinkMs(const ThinkTime& think, bool secondFlip, Rng& rng) {
+    double ms = think.medianMs * exp(think.spread * normalDraw(rng));
+    if (secondFlip) {
+        ms *= SECOND_FLIP_THINK;
+    }
+    return static_cast<int64_t>(min(ms, THINK_LIMIT_MS));
+}
+
+void send(Client& client, const Message& message, LoadRun& run) {
+    encodeMessage(client.output, message);
+    run.stats.messagesOut++;
+    client.requestUs = run.nowUs();
+}
+
+// Send the player's next flip
+void flip(Client& client, LoadRun& run) {
+    Message message;
+    message.type = MessageType::Flip;
+    if (client.first < 0) {
+        message.card = client.player->pickFirst(client.board, client.rng);
+    }
+    else {
+        message.card = client.player->pickSecond(client.board, client.first, client.rng);
+    }
+    send(client, message, run);
+    if (client.first >= 0) {
+        client.secondFlipUs = client.requestUs;
+    }
+    run.stats.flips++;
+}
+
+// Flip once the player has thought about it
+void flipNext(Client& client, LoadRun& run) {
+    if (run.think.medianMs <= 0) {
+        flip(client, run);
+        return;
+    }
+    int64_t delay = thinkMs(run.think, client.first >= 0, client.rng);
+    run.timers.schedule(run.timers.now() + max<int64_t>(delay, 1), static_cast<uint64_t>(client.index));
+}
+
+// Whether a reply's cards and values fit the board it is about; they index
+// the client's board, so anything else is a protocol error
+bool fitsBoard(const CardStore& board, const Message& message) {
+    int cards = board.size();
+    switch (message.type) {
+    case MessageType::LevelStarted:
+        // Players hold a board of at most BITBOARD_MAX_CARDS cards
+        return message.config.pairs >= 1 && 2 * message.config.pairs <= BITBOARD_MAX_CARDS;
+    case MessageType::Revealed:
+        return message.card < cards && message.value >= 1 && message.value <= cards / 2;
+    case MessageType::Match:
+    case MessageType::Mismatch:
+        return message.card < cards && message.other < cards;
+    default:
+        return true;
+    }
+}
+
+// React to one message from the server
+void handle(Client& client, const Message& message, LoadRun& run) {
+    LoadStats& stats = run.stats;
+    stats.messagesIn++;
+
+    // Time the reply could first have been sent
+    int64_t since = client.requestUs;
+    if (message.type == MessageType::LevelStarted && message.level > 0) {
+        since = client.levelDoneUs + LEVEL_TRANSITION_MS * 1000;
+    }
+    else if (message.type == MessageType::Match || message.type == MessageType::Mismatch || message.type == MessageType::GameComplete) {
+        since = client.secondFlipUs + FLIP_BACK_DELAY_MS * 1000;
+    }
+    int64_t now = run.nowUs();
+    if (message.type >= MessageType::LevelStarted && message.type <= MessageType::GameComplete) {
+        stats.latency[replyIndex(message.type)].add(static_cast<uint64_t>(max<int64_t>(now - since, 0)));
+    }
+
+    CardStore& board = client.board;
+    switch (message.type) {
+    case MessageType::LevelStarted:
+        board.values.assign(2 * message.config.pairs, 0);
+        board.revealed.assign(2 * message.config.pairs, 0);
+        board.matched.assign(2 * message.config.pairs, 0);
+        client.player->reset(board.size());
+        client.first = -1;
+        client.pairsLeft = message.config.pairs;
+        flipNext(client, run);
+        break;
+    case MessageType::Revealed:
+        board.values[message.card] = message.value;
+        board.revealed[message.card] = 1;
+        client.player->observe(message.card, message.value);
+        // The second card waits for the server to resolve the pair
+        if (client.first < 0) {
+            client.first = message.card;
+            flipNext(client, run);
+        }
+        else {
+            client.first = -1;
+        }
+        break;
+    case MessageType::Match:
+        board.matched[message.card] = board.matched[message.other] = 1;
+        if (--client.pairsLeft > 0) {
+            flipNext(client, run);
+        }
+        else {
+            client.levelDoneUs = now;
+        }
+        break;
+    case MessageType::Mismatch:
+        board.revealed[message.card] = board.revealed[message.other] = 0;
+        flipNext(client, run);
+        break;
+    case MessageType::Rejected:
+        // Pick again; a player that keeps asking for a face-up card shows up in the count
+        stats.rejected++;
+        flipNext(client, run);
+        break;
+    case MessageType::GameComplete:
+        stats.gamesCompleted++;
+        if (--client.gamesLeft > 0) {
+            Message start;
+            start.type = MessageType::StartGame;
+            send(client, start, run);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+// Write what the socket takes; returns false if the connection failed
+bool flush(Client& client, LoadStats& stats) {
+    if (client.output.overflowed) {
+        stats.overflowed++;
+        return false;
+    }
+    size_t sent = 0;
+    while (sent < client.output.size()) {
+        // A server that closed the connection gets the client counted, not the run stopped by SIGPIPE
+        ssize_t written = ::send(client.socket, client.output.data() + sent, client.output.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return false;
+            }
+            break;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    client.output.consume(sent);
+    return true;
+}
+
+// Read and handle everything the server sent; returns false once the connection is gone
+bool receive(Client& client, LoadRun& run) {
+    MessageBuffer& input = client.input;
+    for (;;) {
+        unsigned char* space = input.space(MESSAGE_MAX_SIZE);
+        size_t room = input.spaceLeft();
+        ssize_t received = ::read(client.socket, space, room);
+        if (received == 0) {
+            return false;
+        }
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+        input.commit(static_cast<size_t>(received));
+
+        Message message;
+        size_t used;
+        for (;;) {
+            DecodeResult result = decodeMessage(input.data(), input.size(), message, used);
+            if (result == DecodeResult::Incomplete) {
+                break;
+            }
+            if (result == DecodeResult::Malformed || !fitsBoard(client.board, message)) {
+                run.stats.malformed++;
+                return false;
+            }
+            input.consume(used);
+            handle(client, message, run);
+        }
+        if (static_cast<size_t>(received) < room) {
+            return true;
+        }
+    }
+}
+
+// Send what the client has queued, or close it once it is done or broken;
+// returns false if it was closed
+bool settle(Client& client, bool alive, int epoll, LoadStats& stats) {
+    if (alive) {
+        alive = flush(client, stats);
+    }
+    bool done = client.gamesLeft == 0;
+    if (!alive || done) {
+        if (!done) {
+            stats.disconnects++;
+        }
+        epoll_ctl(epoll, EPOLL_CTL_DEL, client.socket, nullptr);
+        close(client.socket);
+        client.socket = -1;
+        return false;
+    }
+
+    // Only ask for writability while there is something left to write
+    bool wantWrite = !client.output.empty();
+    if (wantWrite != client.writeRegistered) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        if (wantWrite) {
+            event.events |= EPOLLOUT;
+        }
+        event.data.ptr = &client;
+        epoll_ctl(epoll, EPOLL_CTL_MOD, client.socket, &event);
+        client.writeRegistered = wantWrite;
+    }
+    return true;
+}
+
+void printLatency(const LoadStats& stats) {
+    cout << left << setw(16) << "Latency (ms)" << right << setw(10) << "replies" << setw(9) << "p50" << setw(9) << "p90"
+         << setw(9) << "p99" << setw(9) << "p99.9" << setw(9) << "max" << "\n";
+    for (MessageType type : REPLY_TYPES) {
+        const HdrHistogram& latency = stats.latency[replyIndex(type)];
+        if (latency.samples == 0) {
+            continue;
+        }
+        cout << left << setw(16) << messageName(type) << right << setw(10) << latency.samples << setprecision(2);
+        for (double fraction : { 0.5, 0.9, 0.99, 0.999 }) {
+            cout << setw(9) << latency.percentile(fraction) / 1000.0;
+        }
+        cout << setw(9) << latency.maximum / 1000.0 << "\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    string host = "127.0.0.1";
+    int port = 7777;
+    int clientCount = 1000;
+    int games = 1;
+    string strategy = "perfect";
+    ThinkTime think;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "usage: memmatch-loadgen [--host ADDRESS] [--port N] [--clients N] [--games N] [--strategy NAMES]"
+                 << " [--think-ms N] [--think-spread X] [--seed N]" << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        try {
+            if (option == "--host") host = value;
+            else if (option == "--port") port = stoi(value);
+            else if (option == "--clients") clientCount = stoi(value);
+            else if (option == "--games") games = stoi(value);
+            else if (option == "--strategy") strategy = value;
+            else if (option == "--think-ms") think.medianMs = stod(value);
+            else if (option == "--think-spread") think.spread = stod(value);
+            else if (option == "--seed") seed = stoull(value);
+            else {
+                cerr << "Unknown option " << option << endl;
+                return 2;
+            }
+        }
+        catch (const exception&) {
+            cerr << "Expected a number for " << option << ", got " << value << endl;
+            return 2;
+        }
+    }
+    vector<string> strategies;
+    stringstream names(strategy);
+    for (string name; getline(names, name, ',');) {
+        if (!makePlayer(name)) {
+            cerr << "Unknown strategy " << name << endl;
+            return 2;
+        }
+        strategies.push_back(name);
+    }
+    if (strategies.empty()) {
+        cerr << "--strategy needs at least one name" << endl;
+        return 2;
+    }
+    if (clientCount < 1 || games < 1) {
+        cerr << "--clients and --games must be at least 1" << endl;
+        return 2;
+    }
+    if (think.medianMs < 0 || think.spread < 0) {
+        cerr << "--think-ms and --think-spread must not be negative" << endl;
+        return 2;
+    }
+
+    raiseFileLimit();
+    int epoll = epoll_create1(0);
+    if (epoll < 0) {
+        cerr << "Error creating epoll instance: " << strerror(errno) << endl;
+        return 1;
+    }
+    LoadRun run;
+    run.think = think;
+    LoadStats& stats = run.stats;
+    vector<unique_ptr<Client>> clients;
+    int active = 0;
+    string error;
+    for (int i = 0; i < clientCount; ++i) {
+        unique_ptr<Client> client(new Client());
+        client->socket = connectTcp(host, port, error);
+        if (client->socket < 0) {
+            stats.connectFailures++;
+            continue;
+        }
+        client->index = static_cast<int>(clients.size());
+        client->player = makePlayer(strategies[i % strategies.size()]);
+        client->rng = Rng(deriveSeed(seed, static_cast<uint64_t>(i)));
+        client->gamesLeft = games;
+
+        // Writable once connected, which is when the first game is asked for
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLOUT;
+        event.data.ptr = client.get();
+        epoll_ctl(epoll, EPOLL_CTL_ADD, client->socket, &event);
+        clients.push_back(move(client));
+        active++;
+    }
+    if (stats.connectFailures > 0) {
+        cerr << stats.connectFailures << " connections could not be opened: " << error << endl;
+    }
+
+    epoll_event events[256];
+    while (active > 0) {
+        int count = epoll_wait(epoll, events, 256, static_cast<int>(run.timers.msUntilNext(1000)));
+        for (int i = 0; i < count; ++i) {
+            Client& client = *static_cast<Client*>(events[i].data.ptr);
+            bool alive = !(events[i].events & (EPOLLHUP | EPOLLERR));
+            if (alive && !client.connected && (events[i].events & EPOLLOUT)) {
+                client.connected = true;
+                Message message;
+                message.type = MessageType::StartGame;
+                send(client, message, run);
+            }
+            if (alive && (events[i].events & EPOLLIN)) {
+                alive = receive(client, run);
+            }
+            if (!settle(client, alive, epoll, stats)) {
+                active--;
+            }
+        }
+
+        // Players whose think time is up make their flip
+        run.timers.advance(run.nowUs() / 1000, [&](uint64_t index) {
+            Client& client = *clients[index];
+            if (client.socket < 0) {
+                return;
+            }
+            flip(client, run);
+            if (!settle(client, true, epoll, stats)) {
+                active--;
+            }
+        });
+    }
+    close(epoll);
+
+    double seconds = max(run.nowUs() / 1e6, 1e-9);
+    cout << clients.size() << " clients, " << stats.gamesCompleted << " games in " << fixed << setprecision(2) << seconds << " s ("
+         << setprecision(1) << stats.gamesCompleted / seconds << " games/s, " << stats.flips / seconds << " flips/s)\n";
+    cout << stats.messagesOut << " messages sent, " << stats.messagesIn << " received ("
+         << setprecision(0) << (stats.messagesOut + stats.messagesIn) / seconds << " messages/s)\n";
+    printLatency(stats);
+    cout << stats.rejected << " flips rejected, " << stats.disconnects << " disconnects, "
+         << stats.malformed << " malformed replies, " << stats.overflowed << " overflowed, "
+         << stats.connectFailures << " failed connections" << endl;
+    return stats.disconnects + stats.malformed + stats.overflowed + stats.connectFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,59 @@
+// memmatch-pack: bundle loose asset files into one memory-mappable archive.
+//
+//   memmatch-pack OUTPUT NAME=PATH...
+//
+// Each NAME=PATH adds the file at PATH as entry NAME. When PATH is a
+// directory, every file below it is added as NAME/<relative path>.
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "AssetBundle.h"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cerr << "usage: memmatch-pack OUTPUT NAME=PATH..." << endl;
+        return 2;
+    }
+
+    vector<pair<string, string>> sources;
+    for (int i = 2; i < argc; ++i) {
+        string argument = argv[i];
+        size_t separator = argument.find('=');
+        if (separator == string::npos || separator == 0) {
+            cerr << "Expected NAME=PATH, got " << argument << endl;
+            return 2;
+        }
+        string name = argument.substr(0, separator);
+        fs::path path = argument.substr(separator + 1);
+
+        if (!fs::is_directory(path)) {
+            sources.emplace_back(name, path.string());
+            continue;
+        }
+
+        // Sort directory entries so the same inputs always give the same bundle
+        vector<pair<string, string>> files;
+        for (const auto& entry : fs::recursive_directory_iterator(path)) {
+            if (entry.is_regular_file()) {
+                files.emplace_back(name + "/" + fs::relative(entry.path(), path).generic_string(), entry.path().string());
+            }
+        }
+        sort(files.begin(), files.end());
+        sources.insert(sources.end(), files.begin(), files.end());
+    }
+
+    string error;
+    if (!writeAssetBundle(argv[1], sources, error)) {
+        cerr << "Error writing bundle: " << error << endl;
+        return 1;
+    }
+    cout << "Packed " << sources.size() << " assets into " << argv[1] << endl;
+    return 0;
+}
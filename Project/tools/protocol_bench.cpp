@@ -0,0 +1,239 @@
+// memmatch-protocol-bench: encode and decode throughput of the wire protocol.
+//
+//   memmatch-protocol-bench [--messages N] [--seed N]
+//
+// Runs --messages messages shaped like a game's traffic (flips, reveals,
+// match and mismatch outcomes, level changes) through the encoder and
+// decoder on one thread, so each rate is per core. Messages go straight
+// into preallocated buffers, as the server and load client use them; for
+// comparison, the same messages are also built the way sf::Packet sends
+// them, in a fresh vector per message copied out into a send block.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "GameState.h"
+#include "Protocol.h"
+#include "Random.h"
+
+using namespace std;
+
+// Distinct messages cycled through; enough to keep the branch predictor honest
+const int PATTERN_SIZE = 4096;
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Turns of two flips, each answered with the card's value and then the
+// pair's outcome, with a new level every level's worth of pairs and a
+// completed game after the last level
+vector<Message> makeTraffic(Rng& rng) {
+    vector<Message> messages;
+    int level = 0;
+    int pairsLeft = LEVELS[0].pairs;
+    while (static_cast<int>(messages.size()) < PATTERN_SIZE) {
+        int cards = 2 * LEVELS[level].pairs;
+        int first = static_cast<int>(rng.below(static_cast<uint32_t>(cards)));
+        int second = (first + 1 + static_cast<int>(rng.below(static_cast<uint32_t>(cards - 1)))) % cards;
+        bool match = rng.below(3) == 0;
+
+        Message message;
+        for (int card : { first, second }) {
+            message = Message();
+            message.type = MessageType::Flip;
+            message.card = card;
+            messages.push_back(message);
+            message.type = MessageType::Revealed;
+            message.value = static_cast<int>(rng.below(static_cast<uint32_t>(LEVELS[level].pairs)));
+            messages.push_back(message);
+        }
+        message = Message();
+        message.type = match ? MessageType::Match : MessageType::Mismatch;
+        message.card = first;
+        message.other = second;
+        messages.push_back(message);
+
+        if (match && --pairsLeft == 0) {
+            level = (level + 1) % LEVEL_COUNT;
+            pairsLeft = LEVELS[level].pairs;
+            message = Message();
+            if (level == 0) {
+                message.type = MessageType::GameComplete;
+                message.moves = 100 + static_cast<int>(rng.below(200));
+                messages.push_back(message);
+                message = Message();
+            }
+            message.type = MessageType::LevelStarted;
+            message.level = level;
+            message.config = LEVELS[level];
+            messages.push_back(message);
+        }
+    }
+    messages.resize(PATTERN_SIZE);
+    return messages;
+}
+
+// Encode a message as sf::Packet would: each field appended to the
+// packet's own vector as a big-endian uint16, then the packet copied into
+// the socket's send block behind a size prefix
+size_t encodeAsPacket(const Message& message, vector<unsigned char>& block) {
+    vector<unsigned char> packet;
+    auto append = [&](int value) {
+        packet.push_back(static_cast<unsigned char>(value >> 8));
+        packet.push_back(static_cast<unsigned char>(value));
+    };
+    packet.push_back(static_cast<unsigned char>(message.type));
+    switch (message.type) {
+    case MessageType::Flip:
+    case MessageType::Rejected:
+        append(message.card);
+        break;
+    case MessageType::LevelStarted:
+        append(message.level);
+        append(message.config.pairs);
+        append(message.config.cols);
+        append(message.config.rows);
+        break;
+    case MessageType::Revealed:
+        append(message.card);
+        append(message.value);
+        break;
+    case MessageType::Match:
+    case MessageType::Mismatch:
+        append(message.card);
+        append(message.other);
+        break;
+    case MessageType::GameComplete:
+        append(message.moves);
+        break;
+    default:
+        break;
+    }
+    uint32_t size = static_cast<uint32_t>(packet.size());
+    block.assign(4 + packet.size(), 0);
+    for (int i = 0; i < 4; ++i) {
+        block[i] = static_cast<unsigned char>(size >> (24 - 8 * i));
+    }
+    copy(packet.begin(), packet.end(), block.begin() + 4);
+    return block.size();
+}
+
+void report(const string& name, uint64_t messages, double seconds, uint64_t bytes) {
+    cout << left << setw(34) << name << right << setw(8) << setprecision(1) << messages / seconds / 1e6 << " M messages/s, "
+         << setw(6) << setprecision(1) << seconds * 1e9 / messages << " ns each, " << setprecision(2)
+         << static_cast<double>(bytes) / messages << " bytes per message\n";
+}
+
+int main(int argc, char** argv) {
+    long long messageCount = 50000000;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "usage: memmatch-protocol-bench [--messages N] [--seed N]" << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        try {
+            if (option == "--messages") messageCount = stoll(value);
+            else if (option == "--seed") seed = stoull(value);
+            else {
+                cerr << "Unknown option " << option << endl;
+                return 2;
+            }
+        }
+        catch (const exception&) {
+            cerr << "Expected a number for " << option << ", got " << value << endl;
+            return 2;
+        }
+    }
+    if (messageCount < PATTERN_SIZE) {
+        cerr << "--messages must be at least " << PATTERN_SIZE << endl;
+        return 2;
+    }
+
+    Rng rng(seed);
+    vector<Message> traffic = makeTraffic(rng);
+    uint64_t rounds = static_cast<uint64_t>(messageCount) / PATTERN_SIZE;
+    uint64_t total = rounds * PATTERN_SIZE;
+    cout << fixed << total << " messages on one core\n";
+
+    // Encode into a connection's output buffer, emptied whenever it fills
+    // as if the socket had taken it all
+    MessageBuffer output(64 * 1024);
+    uint64_t bytes = 0;
+    auto start = chrono::steady_clock::now();
+    for (uint64_t round = 0; round < rounds; ++round) {
+        for (const Message& message : traffic) {
+            if (output.spaceLeft() < MESSAGE_MAX_SIZE) {
+                bytes += output.size();
+                output.clear();
+            }
+            encodeMessage(output, message);
+        }
+    }
+    bytes += output.size();
+    report("Encode into buffer", total, secondsSince(start), bytes);
+
+    // Decode a stream of the same messages in place
+    MessageBuffer stream(PATTERN_SIZE * MESSAGE_MAX_SIZE);
+    for (const Message& message : traffic) {
+        encodeMessage(stream, message);
+    }
+    uint64_t checksum = 0;
+    uint64_t decoded = 0;
+    start = chrono::steady_clock::now();
+    for (uint64_t round = 0; round < rounds; ++round) {
+        const unsigned char* data = stream.data();
+        size_t left = stream.size();
+        Message message;
+        size_t used;
+        while (decodeMessage(data, left, message, used) == DecodeResult::Complete) {
+            checksum += static_cast<uint64_t>(message.card + message.value + message.config.pairs);
+            data += used;
+            left -= used;
+            decoded++;
+        }
+    }
+    report("Decode in place", decoded, secondsSince(start), rounds * stream.size());
+
+    // Both ends of a connection: encode into a buffer, decode out of it
+    MessageBuffer wire(4096);
+    start = chrono::steady_clock::now();
+    for (uint64_t round = 0; round < rounds; ++round) {
+        for (const Message& message : traffic) {
+            encodeMessage(wire, message);
+            Message received;
+            size_t used;
+            if (decodeMessage(wire.data(), wire.size(), received, used) == DecodeResult::Complete) {
+                checksum += static_cast<uint64_t>(received.other);
+                wire.consume(used);
+            }
+        }
+    }
+    report("Encode and decode", total, secondsSince(start), bytes);
+
+    // The same messages through a vector per message, as sf::Packet builds them
+    vector<unsigned char> block;
+    uint64_t packetBytes = 0;
+    start = chrono::steady_clock::now();
+    for (uint64_t round = 0; round < rounds; ++round) {
+        for (const Message& message : traffic) {
+            packetBytes += encodeAsPacket(message, block);
+        }
+    }
+    report("Encode as sf::Packet would", total, secondsSince(start), packetBytes);
+
+    if (decoded != total || wire.size() != 0) {
+        cerr << "Error: decoded " << decoded << " of " << total << " messages" << endl;
+        return 1;
+    }
+    cout << "Checksum " << checksum << endl;
+    return 0;
+}
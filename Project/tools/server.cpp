@@ -0,0 +1,132 @@
+// memmatch-server: headless game server, one game session per connection.
+//
+//   memmatch-server [--host ADDRESS] [--port N] [--seed N] [--workers N] [--max-sessions N]
+//
+// The server deals every board and checks every flip; players only learn
+// the value of a card the server turned up for them. Stop it with Ctrl-C.
+// With --seed each game is dealt from a seed derived from it, so a run is
+// repeatable; otherwise every game gets a fresh random seed.
+//
+// Sessions run on --workers threads (one per hardware thread by default),
+// which steal work from each other; the status lines show how busy each
+// one was since the last line, which should stay even as they are added.
+// At most --max-sessions players are connected at once.
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include "GameServer.h"
+#include "Socket.h"
+
+using namespace std;
+
+// Seconds between status lines, and the longest the loop waits before checking for them
+const int REPORT_INTERVAL_S = 5;
+const int POLL_WAIT_MS = 100;
+
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int) {
+    stopRequested = 1;
+}
+
+void printStats(const GameServer& server) {
+    ServerStats stats = server.stats();
+    cout << server.connectionCount() << " connected (" << stats.accepted << " accepted, " << stats.closed << " closed), "
+         << stats.gamesStarted << " games started, " << stats.gamesCompleted << " completed, "
+         << stats.messagesIn << " messages in, " << stats.bytesIn << " bytes in, " << stats.bytesOut << " bytes out";
+    if (stats.malformed > 0) {
+        cout << ", " << stats.malformed << " dropped for malformed messages";
+    }
+    if (stats.overflowed > 0) {
+        cout << ", " << stats.overflowed << " dropped for not reading";
+    }
+    if (stats.refused > 0) {
+        cout << ", " << stats.refused << " refused while full";
+    }
+    cout << endl;
+}
+
+// Share of each worker's time spent working since the previous report, and what it ran
+void printUtilization(const GameServer& server, vector<WorkerStats>& previous) {
+    vector<WorkerStats> current = server.workerStats();
+    previous.resize(current.size());
+    cout << "Workers:" << fixed << setprecision(0);
+    for (size_t i = 0; i < current.size(); ++i) {
+        uint64_t busy = current[i].busyNs - previous[i].busyNs;
+        uint64_t idle = current[i].idleNs - previous[i].idleNs;
+        cout << " " << 100.0 * busy / max<uint64_t>(busy + idle, 1) << "% ("
+             << current[i].messages - previous[i].messages << " messages, "
+             << current[i].steals - previous[i].steals << " stolen)";
+    }
+    cout << endl;
+    previous = current;
+}
+
+int main(int argc, char** argv) {
+    string host = "0.0.0.0";
+    int port = 7777;
+    uint64_t seed = 0;
+    int workers = 0;
+    int maxSessions = 65536;
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "usage: memmatch-server [--host ADDRESS] [--port N] [--seed N] [--workers N] [--max-sessions N]" << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        try {
+            if (option == "--host") host = value;
+            else if (option == "--port") port = stoi(value);
+            else if (option == "--seed") seed = stoull(value);
+            else if (option == "--workers") workers = stoi(value);
+            else if (option == "--max-sessions") maxSessions = stoi(value);
+            else {
+                cerr << "Unknown option " << option << endl;
+                return 2;
+            }
+        }
+        catch (const exception&) {
+            cerr << "Expected a number for " << option << ", got " << value << endl;
+            return 2;
+        }
+    }
+    if (workers < 0 || maxSessions < 1) {
+        cerr << "--workers must not be negative and --max-sessions must be at least 1" << endl;
+        return 2;
+    }
+
+    // Every session holds a socket
+    long files = raiseFileLimit();
+    GameServer server(seed, static_cast<unsigned>(workers), static_cast<size_t>(maxSessions));
+    string error;
+    if (!server.listen(host, port, error)) {
+        cerr << "Error listening on " << host << ":" << port << ": " << error << endl;
+        return 1;
+    }
+    cout << "Listening on " << host << ":" << server.port() << " with " << server.workerStats().size()
+         << " workers, up to " << files << " open files" << endl;
+
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);            // Sessions send with MSG_NOSIGNAL; this covers anything else
+    vector<WorkerStats> reported;
+    auto lastReport = chrono::steady_clock::now();
+    while (!stopRequested) {
+        server.poll(POLL_WAIT_MS);
+        if (chrono::steady_clock::now() - lastReport >= chrono::seconds(REPORT_INTERVAL_S)) {
+            printStats(server);
+            printUtilization(server, reported);
+            lastReport = chrono::steady_clock::now();
+        }
+    }
+    printStats(server);
+    printUtilization(server, reported);
+    return 0;
+}
@@ -0,0 +1,153 @@
+// memmatch-sim: play many boards with simulated players and report how many
+// moves each strategy needs.
+//
+//   memmatch-sim [--pairs N] [--games N] [--strategy NAME[,NAME...]] [--threads N] [--seed N]
+//
+// Strategies are "perfect", "random" and "memory:K" (remembers the last K
+// cards it saw); players track the board in 64-bit masks, so boards hold at
+// most 32 pairs. Games are split across threads, each with its own
+// generator seeded from --seed, so a run is repeatable for a given seed and
+// thread count.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "GameState.h"
+#include "Histogram.h"
+#include "Simulation.h"
+
+using namespace std;
+
+// Play games on one thread into its own histogram
+void simulate(const string& strategy, int pairs, uint64_t games, uint64_t seed, Histogram& histogram) {
+    Rng rng(seed);
+    unique_ptr<Player> player = makePlayer(strategy);
+    GameState game;
+    CardStore cards;
+    for (uint64_t i = 0; i < games; ++i) {
+        setupLevel(cards, pairs, rng);
+        histogram.add(playBoard(game, move(cards), *player, rng));
+        cards = move(game.cards);   // Reuse the board's storage for the next deal
+    }
+}
+
+void printReport(const string& strategy, const Histogram& histogram, double seconds) {
+    uint64_t total = 0;
+    double sum = 0, squares = 0;
+    for (size_t i = 0; i < histogram.counts.size(); ++i) {
+        total += histogram.counts[i];
+        sum += static_cast<double>(i) * histogram.counts[i];
+        squares += static_cast<double>(i) * i * histogram.counts[i];
+    }
+    double mean = sum / total;
+    double deviation = sqrt(max(0.0, squares / total - mean * mean));
+
+    cout << strategy << ": " << total << " games in " << fixed << setprecision(2) << seconds << " s ("
+         << setprecision(0) << total / max(seconds, 1e-9) << " games/s)\n";
+    cout << setprecision(2) << "  moves mean " << mean << ", stddev " << deviation
+         << ", min " << histogram.percentile(0, total) << ", p50 " << histogram.percentile(0.5, total)
+         << ", p90 " << histogram.percentile(0.9, total) << ", p99 " << histogram.percentile(0.99, total)
+         << ", max " << histogram.counts.size() - 1 << "\n";
+
+    // Bar chart of the distribution in up to 20 buckets
+    int low = histogram.percentile(0, total);
+    int high = static_cast<int>(histogram.counts.size()) - 1;
+    int width = max(1, (high - low + 20) / 20);
+    uint64_t largest = 0;
+    vector<uint64_t> buckets;
+    for (int start = low; start <= high; start += width) {
+        uint64_t count = 0;
+        for (int i = start; i < min(start + width, high + 1); ++i) {
+            count += histogram.counts[i];
+        }
+        buckets.push_back(count);
+        largest = max(largest, count);
+    }
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        int start = low + static_cast<int>(b) * width;
+        ostringstream label;
+        label << start;
+        if (width > 1) {
+            label << "-" << start + width - 1;
+        }
+        cout << "  " << setw(9) << label.str() << " " << setw(6) << setprecision(2) << 100.0 * buckets[b] / total << "% "
+             << string(static_cast<size_t>(50.0 * buckets[b] / largest), '#') << "\n";
+    }
+    cout << endl;
+}
+
+int main(int argc, char** argv) {
+    int pairs = LEVELS[LEVEL_COUNT - 1].pairs;
+    uint64_t games = 1000000;
+    unsigned threads = max(1u, thread::hardware_concurrency());
+    uint64_t seed = 1;
+    string strategies = "perfect,memory:8,random";
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "usage: memmatch-sim [--pairs N] [--games N] [--strategy NAME[,NAME...]] [--threads N] [--seed N]" << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        try {
+            if (option == "--pairs") pairs = stoi(value);
+            else if (option == "--games") games = stoull(value);
+            else if (option == "--threads") threads = static_cast<unsigned>(stoul(value));
+            else if (option == "--seed") seed = stoull(value);
+            else if (option == "--strategy") strategies = value;
+            else {
+                cerr << "Unknown option " << option << endl;
+                return 2;
+            }
+        }
+        catch (const exception&) {
+            cerr << "Expected a number for " << option << ", got " << value << endl;
+            return 2;
+        }
+    }
+    if (pairs < 1 || pairs > BITBOARD_MAX_CARDS / 2 || threads < 1) {
+        cerr << "--pairs must be 1.." << BITBOARD_MAX_CARDS / 2 << " and --threads at least 1" << endl;
+        return 2;
+    }
+
+    cout << "Board of " << pairs << " pairs, seed " << seed << ", " << threads << " threads\n" << endl;
+    stringstream names(strategies);
+    string strategy;
+    while (getline(names, strategy, ',')) {
+        if (!makePlayer(strategy)) {
+            cerr << "Unknown strategy " << strategy << endl;
+            return 2;
+        }
+
+        auto start = chrono::steady_clock::now();
+        vector<Histogram> histograms(threads);
+        vector<thread> workers;
+        for (unsigned t = 0; t < threads; ++t) {
+            uint64_t share = games / threads + (t < games % threads ? 1 : 0);
+            // Independent stream per thread, all following from the recorded seed
+            uint64_t threadSeed = deriveSeed(seed, t);
+            workers.emplace_back(simulate, strategy, pairs, share, threadSeed, ref(histograms[t]));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        Histogram total;
+        for (const auto& histogram : histograms) {
+            total.merge(histogram);
+        }
+        if (games > 0) {
+            printReport(strategy, total, seconds);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,72 @@
+// memmatch-solve: compute exact expected move counts under optimal play and
+// export them as a lookup table.
+//
+//   memmatch-solve [--pairs N] [--threads N] [--output FILE]
+//
+// Writes E(n, k) for every board of up to N pairs (500 by default) to FILE
+// (optimal.bin by default); see OptimalPlay.h for the state and file format.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include "GameState.h"
+#include "OptimalPlay.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    int pairs = 500;
+    unsigned threads = 0;
+    string output = "optimal.bin";
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string option = argv[i];
+        string value = argv[i + 1];
+        try {
+            if (option == "--pairs") pairs = stoi(value);
+            else if (option == "--threads") threads = static_cast<unsigned>(stoul(value));
+            else if (option == "--output") output = value;
+            else {
+                cerr << "usage: memmatch-solve [--pairs N] [--threads N] [--output FILE]" << endl;
+                return 2;
+            }
+        }
+        catch (const exception&) {
+            cerr << "Expected a number for " << option << ", got " << value << endl;
+            return 2;
+        }
+    }
+    if (argc % 2 == 0 || pairs < 1) {
+        cerr << "usage: memmatch-solve [--pairs N] [--threads N] [--output FILE]" << endl;
+        return 2;
+    }
+    if (pairs > OPTIMAL_TABLE_MAX_PAIRS) {
+        cerr << "--pairs must be at most " << OPTIMAL_TABLE_MAX_PAIRS << endl;
+        return 2;
+    }
+
+    auto start = chrono::steady_clock::now();
+    OptimalTable table;
+    if (!table.solve(pairs, threads)) {
+        cerr << "Error solving boards of " << pairs << " pairs" << endl;
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    string error;
+    if (!table.save(output, error)) {
+        cerr << "Error saving table: " << error << endl;
+        return 1;
+    }
+
+    cout << "Solved boards of up to " << pairs << " pairs in " << fixed << setprecision(3) << seconds << " s, wrote " << output << "\n";
+    for (int level = 0; level < LEVEL_COUNT; ++level) {
+        if (LEVELS[level].pairs <= pairs) {
+            cout << "  level " << level + 1 << " (" << LEVELS[level].pairs << " pairs): "
+                 << setprecision(4) << table.expectedMoves(LEVELS[level].pairs) << " moves\n";
+        }
+    }
+    cout << "  " << pairs << " pairs: " << table.expectedMoves(pairs) << " moves" << endl;
+    return 0;
+}
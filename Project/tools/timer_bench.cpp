@@ -0,0 +1,149 @@
+// memmatch-timer-bench: throughput of the timer wheel with many timers
+// outstanding, against polling every session each simulation step.
+//
+//   memmatch-timer-bench [--timers N] [--seconds N] [--seed N]
+//
+// Models a server with --timers sessions, each always waiting on a
+// flip-back delay or a level transition. Time is simulated, so the run
+// measures only the CPU cost of keeping the timers: every timer that
+// fires schedules the session's next one, and a share of sessions have
+// theirs cancelled and rescheduled each millisecond, as flips do.
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "GameState.h"
+#include "Random.h"
+#include "Session.h"
+#include "TimerWheel.h"
+
+using namespace std;
+
+// A session as a polling server sees it: its game and when its timer ends
+struct PolledSession {
+    GameSession session;
+    int64_t deadline = 0;
+};
+
+// Sessions per ten thousand whose timer is replaced each simulated
+// millisecond: about one move every two seconds per player
+const int RESCHEDULES_PER_10000 = 5;
+
+double secondsSince(chrono::steady_clock::time_point start) {
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// The next timer a session waits on: mostly flip-back delays, sometimes a level transition
+int64_t nextDelay(Rng& rng) {
+    return rng.below(10) == 0 ? LEVEL_TRANSITION_MS : FLIP_BACK_DELAY_MS;
+}
+
+int main(int argc, char** argv) {
+    int timerCount = 100000;
+    int simulatedSeconds = 60;
+    uint64_t seed = 1;
+
+    for (int i = 1; i < argc; ++i) {
+        string option = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "usage: memmatch-timer-bench [--timers N] [--seconds N] [--seed N]" << endl;
+            return 2;
+        }
+        string value = argv[++i];
+        try {
+            if (option == "--timers") timerCount = stoi(value);
+            else if (option == "--seconds") simulatedSeconds = stoi(value);
+            else if (option == "--seed") seed = stoull(value);
+            else {
+                cerr << "Unknown option " << option << endl;
+                return 2;
+            }
+        }
+        catch (const exception&) {
+            cerr << "Expected a number for " << option << ", got " << value << endl;
+            return 2;
+        }
+    }
+    if (timerCount < 1 || simulatedSeconds < 1) {
+        cerr << "--timers and --seconds must be at least 1" << endl;
+        return 2;
+    }
+
+    Rng rng(seed);
+    TimerWheel wheel;
+    vector<TimerId> ids(timerCount);
+    cout << fixed << setprecision(1);
+
+    // Schedule and cancel in bulk
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < timerCount; ++i) {
+        ids[i] = wheel.schedule(1 + rng.below(LEVEL_TRANSITION_MS), static_cast<uint64_t>(i));
+    }
+    double scheduleSeconds = secondsSince(start);
+    start = chrono::steady_clock::now();
+    for (int i = 0; i < timerCount; ++i) {
+        wheel.cancel(ids[i]);
+    }
+    double cancelSeconds = secondsSince(start);
+    cout << timerCount << " timers: schedule " << scheduleSeconds * 1e9 / timerCount << " ns, cancel "
+         << cancelSeconds * 1e9 / timerCount << " ns\n";
+
+    // Steady state: every session always has one timer outstanding
+    for (int i = 0; i < timerCount; ++i) {
+        ids[i] = wheel.schedule(1 + rng.below(LEVEL_TRANSITION_MS), static_cast<uint64_t>(i));
+    }
+    uint64_t fired = 0;
+    uint64_t rescheduled = 0;
+    int perMillisecond = static_cast<int>(static_cast<int64_t>(timerCount) * RESCHEDULES_PER_10000 / 10000);
+    start = chrono::steady_clock::now();
+    for (int64_t now = 1; now <= simulatedSeconds * 1000LL; ++now) {
+        wheel.advance(now, [&](uint64_t session) {
+            fired++;
+            ids[session] = wheel.schedule(now + nextDelay(rng), session);
+        });
+        for (int i = 0; i < perMillisecond; ++i) {
+            uint32_t session = rng.below(static_cast<uint32_t>(timerCount));
+            wheel.cancel(ids[session]);
+            ids[session] = wheel.schedule(now + nextDelay(rng), session);
+            rescheduled++;
+        }
+    }
+    double wheelSeconds = secondsSince(start);
+    cout << "Wheel: " << simulatedSeconds << " simulated s with " << wheel.size() << " outstanding, "
+         << fired << " fired and " << rescheduled << " rescheduled in " << setprecision(3) << wheelSeconds << " s ("
+         << setprecision(1) << (fired + rescheduled) / wheelSeconds / 1e6 << " M timer operations/s, "
+         << wheelSeconds * 1e3 / simulatedSeconds << " ms CPU per simulated second)\n";
+
+    // Polling: the same sessions and reschedules, with each simulation step
+    // looking at every session. Sessions are allocated one by one, as the
+    // server holds them, so a step touches as much memory as a real one.
+    vector<unique_ptr<PolledSession>> sessions;
+    for (int i = 0; i < timerCount; ++i) {
+        sessions.emplace_back(new PolledSession());
+        sessions.back()->deadline = 1 + rng.below(LEVEL_TRANSITION_MS);
+    }
+    uint64_t polledFires = 0;
+    start = chrono::steady_clock::now();
+    for (int64_t now = 1; now <= simulatedSeconds * 1000LL; ++now) {
+        if (now % SIMULATION_STEP_MS == 0) {
+            for (auto& session : sessions) {
+                if (session->deadline <= now) {
+                    session->deadline = now + nextDelay(rng);
+                    polledFires++;
+                }
+            }
+        }
+        for (int i = 0; i < perMillisecond; ++i) {
+            sessions[rng.below(static_cast<uint32_t>(timerCount))]->deadline = now + nextDelay(rng);
+        }
+    }
+    double pollSeconds = secondsSince(start);
+    cout << "Polling every " << SIMULATION_STEP_MS << " ms: " << polledFires << " fired in " << setprecision(3) << pollSeconds << " s ("
+         << setprecision(1) << pollSeconds * 1e3 / simulatedSeconds << " ms CPU per simulated second, timers up to "
+         << SIMULATION_STEP_MS - 1 << " ms late)" << endl;
+    return 0;
+}